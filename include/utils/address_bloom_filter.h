@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils::btc {
+    // Blocked Bloom filter of addresses. A key sets one bit in each of the 8 words of a single 64 bytes
+    // block, so a probe reads one cache line and nothing else.
+    // Under 1% false positives at the default 12 bits per key, a miss is always a real miss.
+    class AddressBloomFilter {
+    public:
+        static const uint32_t DEFAULT_BITS_PER_KEY = 12;
+
+        AddressBloomFilter(uint64_t expectedKeyCount, uint32_t bitsPerKey = DEFAULT_BITS_PER_KEY);
+
+        // Insert the addresses of an id2addr once each in id order, their count and checksum tell which
+        // id2addr the filter is for
+        void insert(std::string_view address);
+
+        bool mayContain(std::string_view address) const;
+
+        uint64_t getKeyCount() const {
+            return _keyCount;
+        }
+
+        // Saves the filter next to the id2addr it was built from, with the size and modification time of
+        // the id2addr file
+        void saveOf(const std::string& id2AddressFilePath) const;
+
+        static AddressBloomFilter load(const std::string& filePath);
+
+        // The filter of an id2addr is persisted next to it, at the same path with .bloom appended
+        static std::string getFilePath(const std::string& id2AddressFilePath);
+
+        // Returns nullptr if the id2addr has no filter or the filter doesn't match it: the address count
+        // and file size have to be equal, and the checksum of the addresses is verified when the file was
+        // modified after the filter was saved. Filters of version 1 have no checksum and never match.
+        static std::unique_ptr<AddressBloomFilter> loadOf(const std::string& id2AddressFilePath, uint64_t addressCount);
+
+    private:
+        struct alignas(64) Block {
+            uint64_t words[8];
+        };
+
+        AddressBloomFilter() : _version(0), _keyCount(0), _checksum(0), _sourceFileSize(0), _sourceModifiedTime(0) {
+        }
+
+        bool matches(const std::string& id2AddressFilePath, uint64_t addressCount) const;
+
+        std::vector<Block> _blocks;
+        // File version of loaded filters, the current one for built filters
+        uint32_t _version;
+        uint64_t _keyCount;
+        // Order dependent hash of the inserted addresses
+        uint64_t _checksum;
+        uint64_t _sourceFileSize;
+        int64_t _sourceModifiedTime;
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "sorted_merge.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace utils::btc {
+    enum class AddressType : uint8_t {
+        P2PKH = 1,
+        P2SH = 2,
+        P2WPKH = 3,
+        P2WSH = 4,
+        P2TR = 5
+    };
+
+    // Fixed width binary form of a standard address. Base58 addresses keep their 20 bytes hash and
+    // 4 bytes checksum, bech32 addresses their 20 or 32 bytes witness program, the rest is zero.
+    // Keys compare by type and then payload bytes, which is not the order of the address strings.
+    struct AddressKey {
+        static const std::size_t PAYLOAD_SIZE = 32;
+
+        AddressType type;
+        uint8_t payload[PAYLOAD_SIZE];
+
+        bool operator==(const AddressKey& other) const {
+            return std::memcmp(this, &other, sizeof(AddressKey)) == 0;
+        }
+
+        bool operator<(const AddressKey& other) const {
+            return std::memcmp(this, &other, sizeof(AddressKey)) < 0;
+        }
+    };
+
+    static_assert(sizeof(AddressKey) == 1 + AddressKey::PAYLOAD_SIZE);
+
+    struct AddressKeyHash {
+        std::size_t operator()(const AddressKey& key) const {
+            // Payloads are hashes or checksummed, so a few of their bytes are uniform enough
+            uint64_t value;
+            std::memcpy(&value, key.payload + 8, sizeof(value));
+
+            return value ^ static_cast<uint64_t>(key.type);
+        }
+    };
+
+    // Decodes mainnet P2PKH, P2SH, P2WPKH, P2WSH and P2TR addresses. Returns false for any other
+    // string, including addresses with a bad bech32 checksum or not in canonical form, so that
+    // encodeAddress(key) always gives back the same string.
+    bool decodeAddress(std::string_view address, AddressKey& key);
+
+    std::string encodeAddress(const AddressKey& key);
+
+    // Unique addresses kept as keys in an open addressing table, strings decodeAddress can't handle
+    // are kept as they are. One set is filled by one worker.
+    class AddressSet {
+    public:
+        AddressSet();
+
+        void insert(std::string_view address);
+
+        std::size_t size() const {
+            return _keyCount + _others.size();
+        }
+
+        // Bytes allocated by the table and the fallback strings. When the next new key triggers a rehash,
+        // the twice as large table allocated next to the current one is counted too.
+        std::size_t getMemoryUsage() const;
+
+        // Addresses sorted as strings, the order of id2addr, packed into one string. The table is
+        // released before sorting and the set is empty afterwards.
+        utils::PackedLines extractPackedSortedAddresses();
+
+    private:
+        void rehash(std::size_t slotCount);
+
+        // Keys by hash, the zero type marks empty slots, the slot count is a power of 2
+        std::vector<AddressKey> _slots;
+        std::size_t _keyCount;
+        std::unordered_set<std::string> _others;
+        // Nodes and heap strings of _others
+        std::size_t _othersBytes;
+    };
+}
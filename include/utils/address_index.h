@@ -0,0 +1,56 @@
+#pragma once
+
+#include "btc_utils.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils::btc {
+    // Address to id lookup over the lines of an id2addr file. Addresses are kept back to back in one
+    // string arena and found through an open addressing table of ids, so an entry costs its address
+    // bytes plus an offset and two to four slots, and a lookup touches one slot and one arena string.
+    class AddressIndex {
+    public:
+        using Size = BtcId;
+
+        static constexpr BtcId NO_ID = static_cast<BtcId>(-1);
+
+        AddressIndex();
+
+        // Line n of the file gets id n, reading stops at the first empty line like loadId2Address.
+        // A missing file gives an empty index, a duplicated address throws.
+        static AddressIndex load(const std::string& id2AddressFilePath);
+
+        // Returns NO_ID if the address is unknown
+        BtcId find(std::string_view address) const;
+
+        // Returns the id of the address, unknown addresses get the next id
+        BtcId insert(std::string_view address);
+
+        void reserve(Size addressCount, std::size_t addressBytes);
+
+        // Appends the addresses from firstId on to an id2addr file holding ids [0, firstId), so ids
+        // already in the file never change. The file is created if it doesn't exist, a file with more
+        // lines than firstId throws, see utils::openLinesForAppend.
+        void appendToFile(const std::string& id2AddressFilePath, BtcId firstId) const;
+
+        std::string_view getAddress(BtcId id) const {
+            return std::string_view(_arena.data() + _offsets[id], _offsets[id + 1] - _offsets[id]);
+        }
+
+        Size size() const {
+            return _offsets.size() - 1;
+        }
+
+    private:
+        std::size_t findSlot(std::string_view address) const;
+        void rehash(std::size_t slotCount);
+
+        std::string _arena;
+        // Start of every address in the arena and the end of the last one
+        std::vector<uint64_t> _offsets;
+        // Ids by hash, NO_ID for empty slots, the slot count is a power of 2
+        std::vector<BtcId> _slots;
+    };
+}
@@ -6,13 +6,56 @@
 #include <map>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
 
+namespace utils::btc {
+    // 5 bytes id for address spaces beyond 2^32, stored packed and used as uint64_t
+    class PackedId40 {
+    public:
+        static const uint64_t MAX_VALUE = (uint64_t(1) << 40) - 1;
+
+        PackedId40() = default;
+
+        PackedId40(uint64_t value) {
+            for (auto& byte : _bytes) {
+                byte = static_cast<uint8_t>(value);
+                value >>= 8;
+            }
+        }
+
+        operator uint64_t() const {
+            uint64_t value = 0;
+            for (auto byteIt = std::rbegin(_bytes); byteIt != std::rend(_bytes); ++byteIt) {
+                value = (value << 8) | *byteIt;
+            }
+
+            return value;
+        }
+
+    private:
+        uint8_t _bytes[5];
+    };
+
+    static_assert(sizeof(PackedId40) == 5);
+}
+
+// BTC_ID_BITS is set by CMake, BtcIdStorage is the element type of id indexed arrays
+#if BTC_ID_BITS == 64
+using BtcId = uint64_t;
+using BtcIdStorage = uint64_t;
+#elif BTC_ID_BITS == 40
+using BtcId = uint64_t;
+using BtcIdStorage = utils::btc::PackedId40;
+#else
 using BtcId = uint32_t;
+using BtcIdStorage = uint32_t;
+#endif
 
 namespace utils::btc {
     std::vector<std::string> loadId2Address(const char* filePath);
     void loadId2Address(const char* filePath, std::vector<std::string>& id2Address);
     void dumpId2Address(const char* filePath, const std::set<std::string>& id2Address);
+    void dumpId2Address(const char* filePath, const std::vector<std::string>& id2Address);
     std::map<std::string, BtcId> generateAddress2Id(const std::vector<std::string>& id2Address);
     std::map<std::string, BtcId> loadAddress2Id(const char* filePath);
     void loadDayInputs(const char* filePath, std::vector<std::vector<std::vector<BtcId>>>& blocks);
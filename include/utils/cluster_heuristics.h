@@ -0,0 +1,91 @@
+#pragma once
+
+#include "btc_utils.h"
+#include "id_bitset.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace utils::btc {
+    static const BtcId NO_ADDRESS_ID = static_cast<BtcId>(-1);
+
+    struct HeuristicTxOutput {
+        BtcId addressId;
+        uint64_t value;
+    };
+
+    // Addresses of one converted tx, outputs without address keep NO_ADDRESS_ID
+    struct HeuristicTx {
+        // Sorted and unique
+        std::vector<BtcId> inputIds;
+        std::vector<HeuristicTxOutput> outputs;
+    };
+
+    using EdgeFunc = std::function<void(BtcId, BtcId)>;
+
+    // One clustering rule, which reports the address pairs owned by the same entity.
+    // Counters are atomic so one instance is shared by every worker.
+    class ClusterHeuristic {
+    public:
+        ClusterHeuristic(std::string name, std::vector<std::string> counterNames);
+        virtual ~ClusterHeuristic() = default;
+
+        // Returns false if the heuristics after this one must skip the tx
+        virtual bool apply(const HeuristicTx& tx, const EdgeFunc& addEdge) const = 0;
+
+        // Heuristics which only skip txs run before the ones adding edges
+        virtual bool addsEdges() const {
+            return true;
+        }
+
+        const std::string& getName() const {
+            return _name;
+        }
+
+        std::vector<std::pair<std::string, uint64_t>> getCounters() const;
+
+    protected:
+        void count(std::size_t counterIndex, uint64_t value = 1) const {
+            _counters[counterIndex].fetch_add(value, std::memory_order_relaxed);
+        }
+
+    private:
+        std::string _name;
+        std::vector<std::string> _counterNames;
+        std::unique_ptr<std::atomic<uint64_t>[]> _counters;
+    };
+
+    // multi_input, round_change or coinjoin
+    std::unique_ptr<ClusterHeuristic> createClusterHeuristic(const std::string& name);
+
+    // Heuristics applied to every tx of the converted blocks, the ones only skipping txs (coinjoin) first and
+    // the others in the given order. Like btc_gen_day_ins, a tx paying to an excluded (exchange) address is
+    // skipped, and with excludeInputs one spending from it too.
+    class ClusterHeuristics {
+    public:
+        ClusterHeuristics(
+            const std::vector<std::string>& names,
+            const IdBitset* excludeAddresses = nullptr,
+            bool excludeInputs = false
+        );
+
+        void applyToBlock(const nlohmann::json& block, const EdgeFunc& addEdge) const;
+        void applyToTx(const HeuristicTx& tx, const EdgeFunc& addEdge) const;
+
+        // Counters named <heuristic>.<counter>
+        std::vector<std::pair<std::string, uint64_t>> getCounters() const;
+
+    private:
+        bool isExcluded(const HeuristicTx& tx) const;
+
+        std::vector<std::unique_ptr<ClusterHeuristic>> _heuristics;
+        const IdBitset* _excludeAddresses;
+        bool _excludeInputs;
+        mutable std::atomic<uint64_t> _excludedTxCount;
+    };
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "btc_utils.h"
+#include "mmap_utils.h"
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace utils::btc {
+    // Header of binary day inputs files, followed by three sections:
+    // blockCount + 1 offsets into txs, txCount + 1 offsets into ids and the input ids of every tx.
+    // Raw ids are BtcId values and tx offsets count ids. Delta varint ids store the first id of a tx
+    // and then the gaps to the previous id as LEB128, and tx offsets count bytes.
+    struct DayInputsFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t idBytes;
+        uint32_t encoding;
+        uint64_t blockCount;
+        uint64_t txCount;
+        uint64_t idCount;
+        uint64_t blockOffsetsOffset;
+        uint64_t txOffsetsOffset;
+        uint64_t idsOffset;
+        uint64_t idsSize;
+    };
+
+    enum class DayInputsEncoding : uint32_t {
+        Raw = 0,
+        DeltaVarint = 1
+    };
+
+    // Day inputs files with the .bin extension are binary, others are json
+    bool isBinaryDayInputsPath(const std::filesystem::path& path);
+
+    // Input ids of every tx must be sorted and unique for the delta varint encoding
+    void dumpBinaryDayInputs(
+        const std::filesystem::path& path,
+        const std::vector<std::vector<std::vector<BtcId>>>& blocks,
+        DayInputsEncoding encoding
+    );
+
+    // Memory mapped binary day inputs, raw ids are read in place
+    class DayInputsView {
+    public:
+        DayInputsView(const std::filesystem::path& path);
+
+        uint64_t getBlockCount() const {
+            return _blockCount;
+        }
+
+        uint64_t getTxCount() const {
+            return _txCount;
+        }
+
+        uint64_t getIdCount() const {
+            return _idCount;
+        }
+
+        // Calls handler(std::span<const BtcId>) with the input ids of every tx in block order
+        template <class TxFunc>
+        void forEachTx(TxFunc handler) const {
+            if (_encoding == DayInputsEncoding::Raw) {
+                const BtcId* ids = reinterpret_cast<const BtcId*>(_ids);
+                for (uint64_t txIndex = 0; txIndex != _txCount; ++txIndex) {
+                    handler(std::span<const BtcId>(ids + _txOffsets[txIndex], ids + _txOffsets[txIndex + 1]));
+                }
+
+                return;
+            }
+
+            std::vector<BtcId> txIds;
+            for (uint64_t txIndex = 0; txIndex != _txCount; ++txIndex) {
+                const uint8_t* data = _ids + _txOffsets[txIndex];
+                const uint8_t* dataEnd = _ids + _txOffsets[txIndex + 1];
+
+                txIds.clear();
+                BtcId id = 0;
+                while (data != dataEnd) {
+                    id += static_cast<BtcId>(readVarint(data));
+                    txIds.push_back(id);
+                }
+
+                handler(std::span<const BtcId>(txIds));
+            }
+        }
+
+    private:
+        static uint64_t readVarint(const uint8_t*& data) {
+            uint64_t value = 0;
+            for (uint32_t shift = 0; ; shift += 7) {
+                uint8_t byte = *data++;
+                value |= uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+        }
+
+        utils::mmap::MappedFile _file;
+        DayInputsEncoding _encoding;
+        uint64_t _blockCount;
+        uint64_t _txCount;
+        uint64_t _idCount;
+        const uint64_t* _txOffsets;
+        const uint8_t* _ids;
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "btc_utils.h"
+#include "mmap_utils.h"
+#include "union_find.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace utils::btc {
+    // Header of entity index files, followed by three sections of ids:
+    // roots of all entities in ascending order, entityCount + 1 offsets into members
+    // and the member addresses of every entity, sorted by id within each entity.
+    // The source fields identify the union find file the index was built from (added in version 2).
+    struct EntityIndexFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t idBytes;
+        uint32_t reserved;
+        uint64_t entityCount;
+        uint64_t idCount;
+        uint64_t rootsOffset;
+        uint64_t offsetsOffset;
+        uint64_t membersOffset;
+        uint64_t sourceFileSize;
+        int64_t sourceModifiedTime;
+        uint64_t sourceChecksum;
+    };
+
+    // Index file written next to the union find file by default
+    std::filesystem::path getEntityIndexPath(const std::filesystem::path& unionFindFilePath);
+
+    void buildEntityIndex(const UnionFindView& quickUnion, const std::filesystem::path& path, uint32_t workerCount);
+
+    class EntityIndexView;
+
+    // Maps the index at getEntityIndexPath of the union find file. Returns nullptr if there is none or it
+    // doesn't match the union find file, so callers fall back to scanning the union find.
+    std::unique_ptr<EntityIndexView> loadEntityIndexOf(const UnionFindView& quickUnion);
+
+    // Memory mapped entity index, members of an entity are read without touching other entities
+    class EntityIndexView {
+    public:
+        using Members = std::span<const BtcIdStorage>;
+
+        static const BtcSize NO_ENTITY = static_cast<BtcSize>(-1);
+
+        EntityIndexView(const std::filesystem::path& path);
+
+        // NO_ENTITY if rootId isn't the root of an entity
+        BtcSize findEntity(BtcId rootId) const;
+        Members getMembers(BtcSize entityIndex) const;
+        Members getMembersOfRoot(BtcId rootId) const;
+
+        BtcId getRoot(BtcSize entityIndex) const {
+            return _roots[entityIndex];
+        }
+
+        BtcSize getEntityCount() const {
+            return _entityCount;
+        }
+
+        BtcSize getSize() const {
+            return _idCount;
+        }
+
+        // False when the union find file changed after the index was built. Files with a header are
+        // compared by checksum, legacy files by modification time.
+        bool matches(const UnionFindView& quickUnion) const;
+
+    private:
+        utils::mmap::MappedFile _file;
+        const BtcIdStorage* _roots;
+        const BtcIdStorage* _offsets;
+        const BtcIdStorage* _members;
+        BtcSize _entityCount;
+        BtcSize _idCount;
+        uint64_t _sourceFileSize;
+        int64_t _sourceModifiedTime;
+        uint64_t _sourceChecksum;
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "btc_utils.h"
+#include "mmap_utils.h"
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace utils::btc {
+    // Header of binary id2addr files, followed by addressCount + 1 offsets into the addresses,
+    // the addresses and an optional hash index of slotCount ids. Addresses keep their '\n'
+    // separators, so the address section is the text id2addr file and the offsets are line starts.
+    // The hash index uses FNV-1a with linear probing, NO_ID marks empty slots.
+    struct Id2AddressFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t idBytes;
+        uint32_t reserved;
+        uint64_t addressCount;
+        uint64_t offsetsOffset;
+        uint64_t addressesOffset;
+        uint64_t addressesSize;
+        uint64_t slotsOffset;
+        uint64_t slotCount;
+    };
+
+    // FNV-1a of an address, stable across builds unlike std::hash, for hashes stored in files
+    inline uint64_t hashAddressFnv1a(std::string_view address) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (char c : address) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ULL;
+        }
+
+        return hash;
+    }
+
+    // Id2addr files with the .bin extension are binary, others are text
+    bool isBinaryId2AddressPath(const std::filesystem::path& path);
+
+    // Read only id to address lookup. Binary files are used in place, text files are mapped and
+    // only their line offsets are built, so no address is copied in either case.
+    class Id2AddressView {
+    public:
+        static constexpr BtcId NO_ID = static_cast<BtcId>(-1);
+
+        // Text files stop at the first empty line like loadId2Address
+        Id2AddressView(const std::filesystem::path& path);
+
+        Id2AddressView(const Id2AddressView&) = delete;
+        Id2AddressView& operator=(const Id2AddressView&) = delete;
+
+        std::string_view getAddress(BtcId id) const {
+            return std::string_view(_addresses + _offsets[id], _offsets[id + 1] - _offsets[id] - 1);
+        }
+
+        std::string_view operator[](BtcId id) const {
+            return getAddress(id);
+        }
+
+        uint64_t size() const {
+            return _addressCount;
+        }
+
+        bool hasHashIndex() const {
+            return _slotCount != 0;
+        }
+
+        // Returns NO_ID if the address is unknown, throws if the file has no hash index
+        BtcId find(std::string_view address) const;
+
+        // Writes the addresses as a binary id2addr file, with a hash index at most half full if asked
+        void dump(const std::filesystem::path& path, bool withHashIndex) const;
+
+    private:
+        void mapBinaryFile(const std::filesystem::path& path);
+        void indexTextFile();
+
+        utils::mmap::MappedFile _file;
+        // Line offsets of text files, binary files point into the mapping
+        std::vector<uint64_t> _textOffsets;
+        uint64_t _addressCount;
+        const uint64_t* _offsets;
+        const char* _addresses;
+        uint64_t _slotCount;
+        const BtcId* _slots;
+    };
+}
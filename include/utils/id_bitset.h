@@ -0,0 +1,52 @@
+#pragma once
+
+#include "btc_utils.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace utils::btc {
+    // Dense set of ids with one bit per id, for large sets queried on every tx
+    class IdBitset {
+    public:
+        using Size = BtcId;
+
+        IdBitset(Size size = 0);
+
+        // Loads a file with one id per line, the bitset is sized by the largest id
+        static IdBitset loadIdList(const std::string& filePath);
+        // Loads a bitmap file written by save
+        static IdBitset load(const std::string& filePath);
+
+        void save(const std::string& filePath) const;
+
+        bool contains(BtcId id) const {
+            return id < _size && (_words[id >> 6] >> (id & 63)) & 1;
+        }
+
+        // Grows the bitset if id is out of range
+        void insert(BtcId id) {
+            if (id >= _size) {
+                resize(id + 1);
+            }
+
+            _words[id >> 6] |= uint64_t(1) << (id & 63);
+        }
+
+        void resize(Size size);
+
+        // Union with another bitset, grows to the larger size
+        IdBitset& operator|=(const IdBitset& rhs);
+
+        // Number of ids in the set
+        Size count() const;
+
+        Size getSize() const {
+            return _size;
+        }
+
+    private:
+        std::vector<uint64_t> _words;
+        Size _size;
+    };
+}
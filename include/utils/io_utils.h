@@ -2,6 +2,7 @@
 
 #include "fmt/format.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <set>
@@ -36,6 +37,12 @@ namespace utils {
 
     void copyStream(std::istream& is, std::ostream& os);
 
+    // Opens a file of lineCount lines, like an id2addr holding ids [0, lineCount), to append lines that
+    // continue its numbering. A last line without '\n' is ended and blank lines after the counted ones are
+    // cut off. Any other content after them throws, appended lines would get the wrong line numbers.
+    // A missing file is created.
+    std::ofstream openLinesForAppend(const std::string& filePath, uint64_t lineCount);
+
     template <typename T>
     void writeLines(const std::string& filePath, const std::vector<T>& lines) {
         std::ofstream outputFile(filePath);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "mmap_utils.h"
+#include "task_utils.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace utils {
+    // Splits text into about chunkCount parts that end right after a '\n', or at the end of the text
+    std::vector<std::string_view> splitLineChunks(std::string_view text, std::size_t chunkCount);
+
+    // Calls handler(std::string_view line) for every line of a chunk, skipping empty lines. A trailing '\r'
+    // is removed, so files written on Windows parse the same.
+    template <class LineFunc>
+    void forEachLineOfChunk(std::string_view chunk, LineFunc& handler) {
+        while (!chunk.empty()) {
+            std::size_t lineEnd = chunk.find('\n');
+            std::string_view line = chunk.substr(0, lineEnd);
+            chunk.remove_prefix(lineEnd == std::string_view::npos ? chunk.size() : lineEnd + 1);
+
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+
+            if (!line.empty()) {
+                handler(line);
+            }
+        }
+    }
+
+    // Parses the whole text as T with std::from_chars, throws for anything else
+    template <class T>
+    T parseNumber(std::string_view text, const std::string& filePath) {
+        T value;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size()) {
+            throw std::runtime_error(fmt::format("Invalid number {} in {}", text, filePath));
+        }
+
+        return value;
+    }
+
+    // Maps the file and runs the chunks of its lines on workerCount workers. handlerFactory(chunkIndex)
+    // returns the line handler of a chunk, chunks are numbered in file order.
+    template <class LineFuncFactory>
+    void forEachLineInParallel(const std::string& filePath, LineFuncFactory handlerFactory, uint32_t workerCount) {
+        utils::mmap::MappedFile inputFile(filePath);
+        const auto& chunks = splitLineChunks(std::string_view(inputFile.data(), inputFile.size()), workerCount);
+
+        runRangesInParallel(chunks.size(), workerCount, [&](uint64_t chunkBegin, uint64_t chunkEnd) {
+            for (uint64_t chunkIndex = chunkBegin; chunkIndex != chunkEnd; ++chunkIndex) {
+                auto handler = handlerFactory(chunkIndex);
+                forEachLineOfChunk(chunks[chunkIndex], handler);
+            }
+        });
+    }
+
+    inline uint32_t getDefaultLoaderWorkerCount() {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // Loads a file of one number per line, values keep the file order
+    template <class T>
+    std::vector<T> loadNumberLines(const std::string& filePath, uint32_t workerCount = getDefaultLoaderWorkerCount()) {
+        workerCount = std::max(workerCount, 1u);
+        std::vector<std::vector<T>> chunkValues(workerCount);
+        forEachLineInParallel(filePath, [&](std::size_t chunkIndex) {
+            return [&values = chunkValues[chunkIndex], &filePath](std::string_view line) {
+                values.push_back(parseNumber<T>(line, filePath));
+            };
+        }, workerCount);
+
+        std::size_t valueCount = 0;
+        for (const auto& values : chunkValues) {
+            valueCount += values.size();
+        }
+
+        std::vector<T> results;
+        results.reserve(valueCount);
+        for (const auto& values : chunkValues) {
+            results.insert(results.end(), values.cbegin(), values.cend());
+        }
+
+        return results;
+    }
+
+    // Calls handler(Id, Value) for every "id,value" line, from several workers at once, so the handler
+    // has to be safe for concurrent calls with different ids. Lines without ',' are skipped like the
+    // getline loaders did, returns the count of id,value lines.
+    template <class Id, class Value, class IdValueFunc>
+    uint64_t forEachIdValueLine(
+        const std::string& filePath,
+        IdValueFunc handler,
+        uint32_t workerCount = getDefaultLoaderWorkerCount()
+    ) {
+        workerCount = std::max(workerCount, 1u);
+        std::vector<uint64_t> chunkLineCounts(workerCount, 0);
+        forEachLineInParallel(filePath, [&](std::size_t chunkIndex) {
+            return [&lineCount = chunkLineCounts[chunkIndex], &handler, &filePath](std::string_view line) {
+                std::size_t separatorPos = line.find(',');
+                if (separatorPos == std::string_view::npos) {
+                    return;
+                }
+
+                handler(
+                    parseNumber<Id>(line.substr(0, separatorPos), filePath),
+                    parseNumber<Value>(line.substr(separatorPos + 1), filePath)
+                );
+                ++lineCount;
+            };
+        }, workerCount);
+
+        uint64_t lineCount = 0;
+        for (auto chunkLineCount : chunkLineCounts) {
+            lineCount += chunkLineCount;
+        }
+
+        return lineCount;
+    }
+}
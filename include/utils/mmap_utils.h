@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace utils::mmap {
+    // Read only mapping of a whole file, pages are loaded by the OS on first access
+    class MappedFile {
+    public:
+        MappedFile(const std::string& filePath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const {
+            return _data;
+        }
+
+        std::size_t size() const {
+            return _size;
+        }
+
+    private:
+        const char* _data;
+        std::size_t _size;
+
+#ifdef _MSC_VER
+        void* _fileHandle;
+        void* _mappingHandle;
+#endif //_MSC_VER
+    };
+
+    // Read write shared mapping of a file created with the given size, changes go to the file
+    class WritableMappedFile {
+    public:
+        WritableMappedFile(const std::string& filePath, std::size_t size);
+        ~WritableMappedFile();
+
+        WritableMappedFile(const WritableMappedFile&) = delete;
+        WritableMappedFile& operator=(const WritableMappedFile&) = delete;
+
+        // Writes dirty pages back and unmaps, data() is invalid afterwards
+        void close();
+
+        char* data() const {
+            return _data;
+        }
+
+        std::size_t size() const {
+            return _size;
+        }
+
+    private:
+        char* _data;
+        std::size_t _size;
+
+#ifdef _MSC_VER
+        void* _fileHandle;
+        void* _mappingHandle;
+#endif //_MSC_VER
+    };
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "mmap_utils.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace utils {
+    // Lines back to back in one string, a line costs its bytes and 8 bytes of offset and length
+    // instead of a std::string and its own allocation
+    class PackedLines {
+    public:
+        void reserve(std::size_t lineCount, std::size_t byteCount) {
+            _lines.reserve(lineCount);
+            _arena.reserve(byteCount);
+        }
+
+        void push_back(std::string_view line);
+
+        std::size_t size() const {
+            return _lines.size();
+        }
+
+        bool empty() const {
+            return _lines.empty();
+        }
+
+        std::string_view operator[](std::size_t index) const {
+            uint64_t line = _lines[index];
+            return std::string_view(_arena.data() + (line >> LENGTH_BITS), line & LENGTH_MASK);
+        }
+
+        // Sorts the lines as strings, only the line references move
+        void sort();
+
+        // Index of the first line not less than line, the lines must be sorted
+        std::size_t lowerBound(std::string_view line) const;
+
+    private:
+        static const uint32_t LENGTH_BITS = 16;
+        static const uint64_t LENGTH_MASK = (uint64_t(1) << LENGTH_BITS) - 1;
+
+        std::string _arena;
+        // Offset in the arena << LENGTH_BITS | length
+        std::vector<uint64_t> _lines;
+    };
+
+    // Range [begin, end) of sorted packed lines in memory, read front to back
+    class SortedPackedRun {
+    public:
+        SortedPackedRun(const PackedLines& lines, std::size_t begin, std::size_t end) :
+            _lines(&lines), _index(begin), _end(end) {
+        }
+
+        bool empty() const {
+            return _index == _end;
+        }
+
+        std::string_view front() const {
+            return (*_lines)[_index];
+        }
+
+        void pop() {
+            ++_index;
+        }
+
+    private:
+        const PackedLines* _lines;
+        std::size_t _index;
+        std::size_t _end;
+    };
+
+    // Sorted lines of a mapped file, read front to back, empty lines are skipped.
+    // pop() throws if the next line sorts before the current one.
+    class SortedFileRun {
+    public:
+        SortedFileRun(const std::string& filePath);
+
+        bool empty() const {
+            return _lineBegin == _dataEnd;
+        }
+
+        std::string_view front() const {
+            return std::string_view(_lineBegin, _lineEnd - _lineBegin);
+        }
+
+        void pop();
+
+    private:
+        void seekLine();
+
+        std::string _filePath;
+        std::unique_ptr<utils::mmap::MappedFile> _file;
+        const char* _lineBegin;
+        const char* _lineEnd;
+        const char* _dataEnd;
+    };
+
+    // Merges sorted runs into one sorted sequence without duplicates and calls handler(std::string_view)
+    // for every line. A run has empty(), front() and pop(), front() stays valid until the next pop().
+    template <class Run, class LineFunc>
+    void mergeSortedUnique(std::vector<Run>& runs, LineFunc handler) {
+        using HeapItem = std::pair<std::string_view, std::size_t>;
+        std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+        for (std::size_t runIndex = 0; runIndex != runs.size(); ++runIndex) {
+            if (!runs[runIndex].empty()) {
+                heap.emplace(runs[runIndex].front(), runIndex);
+            }
+        }
+
+        std::string lastLine;
+        bool hasLastLine = false;
+        while (!heap.empty()) {
+            auto [line, runIndex] = heap.top();
+            heap.pop();
+
+            if (!hasLastLine || line != lastLine) {
+                handler(line);
+                lastLine.assign(line);
+                hasLastLine = true;
+            }
+
+            auto& run = runs[runIndex];
+            run.pop();
+            if (!run.empty()) {
+                heap.emplace(run.front(), runIndex);
+            }
+        }
+    }
+
+    // Writes the unique lines of the sorted runs to filePath, one per line. The line range is split by
+    // sampled splitters, every worker merges its own part of all runs once into a buffer and the buffers
+    // are copied to their place in the mapped file. Returns the line count.
+    uint64_t writeSortedUniqueLines(
+        const std::string& filePath,
+        const std::vector<PackedLines>& runs,
+        uint32_t workerCount
+    );
+
+    // Writes sorted lines as a run file for mergeSortedUniqueFiles
+    void dumpSortedRun(const std::string& filePath, const PackedLines& lines);
+
+    // Streams the unique lines of sorted files to outputFilePath, memory doesn't grow with the inputs.
+    // Returns the line count.
+    uint64_t mergeSortedUniqueFiles(const std::string& outputFilePath, const std::vector<std::string>& inputFilePaths);
+}
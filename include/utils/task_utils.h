@@ -4,6 +4,7 @@
 #include <vector>
 #include <cstdint>
 #include <future>
+#include <algorithm>
 
 #include "fmt/format.h"
 
@@ -25,6 +26,21 @@ namespace utils {
         return taskChunks;
     }
 
+    // Splits [0, count) into one contiguous range per worker and waits for all of them
+    template <class RangeFunc>
+    void runRangesInParallel(uint64_t count, uint32_t workerCount, RangeFunc handler) {
+        uint64_t chunkSize = std::max<uint64_t>((count + workerCount - 1) / std::max(workerCount, 1u), 1);
+
+        std::vector<std::future<void>> tasks;
+        for (uint64_t chunkBegin = 0; chunkBegin < count; chunkBegin += chunkSize) {
+            tasks.push_back(std::async(std::launch::async, handler, chunkBegin, std::min(count, chunkBegin + chunkSize)));
+        }
+
+        for (auto& task : tasks) {
+            task.get();
+        }
+    }
+
     template <class T, class Logger>
     void waitForTasks(Logger& logger, std::vector<std::future<T>>& tasks) {
         int32_t taskIndex = 0;
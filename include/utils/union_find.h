@@ -1,69 +1,393 @@
 #pragma once
 
 #include "btc_utils.h"
+#include "mmap_utils.h"
 #include <cstdint>
+#include <string>
 #include <vector>
 #include <filesystem>
 #include <iostream>
+#include <fstream>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <span>
 
 namespace utils::btc {
     using BtcSize = BtcId;
 
-    class WeightedQuickUnion;
+    // Integer type used in the interface for an id storage type
+    template <typename IdStorage>
+    struct IdTraits {
+        using Id = IdStorage;
+    };
+
+    template <>
+    struct IdTraits<PackedId40> {
+        using Id = uint64_t;
+    };
+
+    // Header of .uf files, followed by the sections at the given offsets (0 if absent):
+    // ids, sizes (meaningful for roots only), frozen roots (root of every id) and applied days.
+    // Files without the magic are the legacy layout: clusterCount, maxId, ids, sizes.
+    struct UnionFindFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t byteOrderMark;
+        uint32_t idBytes;
+        uint64_t clusterCount;
+        uint64_t idCount;
+        uint64_t idsOffset;
+        uint64_t sizesOffset;
+        uint64_t rootsOffset;
+        uint64_t appliedDaysOffset;
+        // Over all bytes after the header
+        uint64_t checksum;
+    };
+
+    template <typename IdStorage>
+    class BasicWeightedQuickUnion;
+
+    template <typename IdStorage>
+    std::ostream& operator<<(std::ostream& os, const BasicWeightedQuickUnion<IdStorage>& quickUnion);
+
+    template <typename IdStorage>
+    class BasicWeightedQuickUnionClusters;
 
-    std::ostream& operator<<(std::ostream& os, const WeightedQuickUnion& quickUnion);
-    
-    class WeightedQuickUnionClusters;
+    template <typename IdStorage>
+    class BasicRankedQuickUnionClusters;
 
-    class WeightedQuickUnion {
+    class VersionedQuickUnion;
+
+    template <typename IdStorage>
+    class BasicWeightedQuickUnion {
     public:
-        friend std::ostream& operator<<(std::ostream& os, const WeightedQuickUnion& quickUnion);
-        friend class WeightedQuickUnionClusters;
+        using Id = typename IdTraits<IdStorage>::Id;
+        using Size = Id;
 
-        WeightedQuickUnion(BtcSize idCount);
+        friend std::ostream& operator<< <>(std::ostream& os, const BasicWeightedQuickUnion& quickUnion);
+        friend class BasicWeightedQuickUnionClusters<IdStorage>;
+        friend class VersionedQuickUnion;
 
-        bool connected(BtcId p, BtcId q);
-        BtcId findRoot(BtcId p) const;
-        BtcSize getClusterSize(BtcId p) const;
-        void connect(BtcId p, BtcId q);
-        void merge(const WeightedQuickUnion& rhs);
+        BasicWeightedQuickUnion(Size idCount);
+
+        bool connected(Id p, Id q);
+        Id findRoot(Id p) const;
+        // Resolves out[i] = findRoot(in[i]) with many lookups in flight at once
+        void findRoots(std::span<const Id> in, std::span<Id> out) const;
+        Size getClusterSize(Id p) const;
+        void connect(Id p, Id q);
+        void link(Id childRoot, Id parentRoot);
+        void merge(const BasicWeightedQuickUnion& rhs);
         void save(const std::filesystem::path& path) const;
+        void save(
+            const std::filesystem::path& path,
+            const std::vector<std::string>& appliedDays,
+            bool withFrozenRoots = false
+        ) const;
         void load(const std::filesystem::path& path);
-        void resize(BtcSize newSize);
+        void load(const std::filesystem::path& path, std::vector<std::string>& appliedDays);
+        void resize(Size newSize);
 
-        BtcSize getClusterCount() const {
+        Size getClusterCount() const {
             return _clusterCount;
         }
 
-        BtcSize getSize() const {
+        Size getSize() const {
             return _ids.size();
         }
 
-        bool operator==(const WeightedQuickUnion& rhs) const {
+        bool operator==(const BasicWeightedQuickUnion& rhs) const {
             return _ids == rhs._ids &&
                 _sizes == rhs._sizes &&
-                _clusterCount == _clusterCount;
+                _clusterCount == rhs._clusterCount;
+        }
+
+    private:
+        std::vector<IdStorage> _ids;
+        std::vector<IdStorage> _sizes;
+        Size _clusterCount;
+    };
+
+    template <typename IdStorage>
+    class BasicWeightedQuickUnionClusters {
+    public:
+        using Id = typename BasicWeightedQuickUnion<IdStorage>::Id;
+        using Size = typename BasicWeightedQuickUnion<IdStorage>::Size;
+        using ForEachFunc = std::function<void(Id, Size)>;
+
+        BasicWeightedQuickUnionClusters(const BasicWeightedQuickUnion<IdStorage>& quickUnion);
+
+        void forEach(ForEachFunc handler) const;
+
+    private:
+        const BasicWeightedQuickUnion<IdStorage>& _quickUnion;
+    };
+
+    // Width of WeightedQuickUnion follows BTC_ID_BITS, other widths can be used directly
+    using WeightedQuickUnion = BasicWeightedQuickUnion<BtcIdStorage>;
+    using WeightedQuickUnionClusters = BasicWeightedQuickUnionClusters<BtcIdStorage>;
+
+    // Union by rank with 1 byte ranks instead of full width sizes, about half the memory of WeightedQuickUnion.
+    // Reads and writes the same file format, cluster sizes are computed by an extra pass when they are needed.
+    template <typename IdStorage>
+    class BasicRankedQuickUnion {
+    public:
+        using Id = typename IdTraits<IdStorage>::Id;
+        using Size = Id;
+
+        friend class BasicRankedQuickUnionClusters<IdStorage>;
+
+        BasicRankedQuickUnion(Size idCount);
+
+        bool connected(Id p, Id q);
+        Id findRoot(Id p) const;
+        void findRoots(std::span<const Id> in, std::span<Id> out) const;
+        void connect(Id p, Id q);
+        void merge(const BasicRankedQuickUnion& rhs);
+        void save(const std::filesystem::path& path) const;
+        void save(
+            const std::filesystem::path& path,
+            const std::vector<std::string>& appliedDays,
+            bool withFrozenRoots = false
+        ) const;
+        void load(const std::filesystem::path& path);
+        void load(const std::filesystem::path& path, std::vector<std::string>& appliedDays);
+        void resize(Size newSize);
+
+        // Sizes indexed by id, 0 for non root ids
+        std::vector<IdStorage> computeClusterSizes() const;
+
+        // Sizes of the roots with rank > 0 sorted by root, a root of rank 0 never got a child so its size is 1.
+        // Built once on first use and shared by concurrent readers, any change to the union find drops it.
+        const std::vector<std::pair<IdStorage, IdStorage>>& getRootSizes() const;
+
+        Size getClusterCount() const {
+            return _clusterCount;
+        }
+
+        Size getSize() const {
+            return _ids.size();
+        }
+
+        bool operator==(const BasicRankedQuickUnion& rhs) const {
+            return _ids == rhs._ids &&
+                _ranks == rhs._ranks &&
+                _clusterCount == rhs._clusterCount;
+        }
+
+    private:
+        Id findRootAndHalve(Id p);
+        void dropRootSizes();
+
+        std::vector<IdStorage> _ids;
+        std::vector<uint8_t> _ranks;
+        Size _clusterCount;
+
+        mutable std::mutex _rootSizesMutex;
+        mutable std::unique_ptr<std::vector<std::pair<IdStorage, IdStorage>>> _rootSizes;
+    };
+
+    template <typename IdStorage>
+    class BasicRankedQuickUnionClusters {
+    public:
+        using Id = typename BasicRankedQuickUnion<IdStorage>::Id;
+        using Size = typename BasicRankedQuickUnion<IdStorage>::Size;
+        using ForEachFunc = std::function<void(Id, Size)>;
+
+        BasicRankedQuickUnionClusters(const BasicRankedQuickUnion<IdStorage>& quickUnion);
+
+        void forEach(ForEachFunc handler) const;
+
+    private:
+        const BasicRankedQuickUnion<IdStorage>& _quickUnion;
+    };
+
+    using RankedQuickUnion = BasicRankedQuickUnion<BtcIdStorage>;
+    using RankedQuickUnionClusters = BasicRankedQuickUnionClusters<BtcIdStorage>;
+
+    // Read only union find over a memory mapped .uf file, nothing is read until it is looked up.
+    // Lookups are a single read when the file has frozen roots. The checksum is only verified by load.
+    template <typename IdStorage>
+    class BasicUnionFindView {
+    public:
+        using Id = typename IdTraits<IdStorage>::Id;
+        using Size = Id;
+
+        BasicUnionFindView(const std::filesystem::path& path);
+
+        Id findRoot(Id p) const;
+        void findRoots(std::span<const Id> in, std::span<Id> out) const;
+        Size getClusterSize(Id p) const;
+
+        Size getClusterCount() const {
+            return _clusterCount;
+        }
+
+        Size getSize() const {
+            return _idCount;
+        }
+
+        bool hasFrozenRoots() const {
+            return _roots != nullptr;
+        }
+
+        Id getParent(Id p) const {
+            return _ids[p];
+        }
+
+        // 0 for legacy files, which have no header
+        uint64_t getChecksum() const {
+            return _checksum;
+        }
+
+        uint64_t getFileSize() const {
+            return _file.size();
+        }
+
+        const std::filesystem::path& getPath() const {
+            return _path;
+        }
+
+    private:
+        std::filesystem::path _path;
+        utils::mmap::MappedFile _file;
+        const IdStorage* _ids;
+        const IdStorage* _sizes;
+        const IdStorage* _roots;
+        Size _clusterCount;
+        Size _idCount;
+        uint64_t _checksum;
+    };
+
+    using UnionFindView = BasicUnionFindView<BtcIdStorage>;
+
+    // Union find which many threads can connect at once. Roots are linked by CAS with the larger id
+    // under the smaller one, so parents only decrease and concurrent links never form a cycle.
+    class ConcurrentQuickUnion {
+    public:
+        ConcurrentQuickUnion(BtcSize idCount);
+
+        BtcId findRoot(BtcId p);
+        void connect(BtcId p, BtcId q);
+        // Streams the ids section of a .uf file in chunks and applies its links on workerCount threads
+        void merge(const std::filesystem::path& path, uint32_t workerCount);
+        // Flattens every id to its root and writes a .uf file with sizes
+        void save(const std::filesystem::path& path, uint32_t workerCount);
+        // Not thread safe
+        void resize(BtcSize newSize);
+
+        BtcSize getSize() const {
+            return _ids.size();
         }
 
     private:
         std::vector<BtcId> _ids;
-        std::vector<BtcSize> _sizes;
+    };
+
+    // Weighted union find working in place inside a .uf file mapped read write, so the OS pages ids
+    // and sizes in and out instead of keeping them in RAM. Edges are buffered and applied sorted by
+    // address, which turns most page-ins of a batch into one sweep over the file. Only the edge buffer
+    // is bounded, how many pages stay resident is up to the OS.
+    class ExternalQuickUnion {
+    public:
+        ExternalQuickUnion(const std::filesystem::path& path, BtcSize idCount, std::size_t edgeBufferCount);
+
+        void connect(BtcId p, BtcId q);
+        // Applies buffered edges
+        void flush();
+        // Flushes and completes the file with its header and applied days, no more connects after it
+        void close(const std::vector<std::string>& appliedDays);
+
+        BtcSize getClusterCount() const {
+            return _clusterCount;
+        }
+
+        BtcSize getSize() const {
+            return _idCount;
+        }
+
+    private:
+        BtcId findRoot(BtcId p);
+
+        std::filesystem::path _path;
+        utils::mmap::WritableMappedFile _file;
+        BtcIdStorage* _ids;
+        BtcIdStorage* _sizes;
+        std::vector<std::pair<BtcId, BtcId>> _edges;
+        std::size_t _edgeBufferCount;
+        BtcSize _idCount;
         BtcSize _clusterCount;
     };
 
-    class WeightedQuickUnionClusters {
+    struct UnionLogEntry {
+        uint32_t dayIndex;
+        BtcId childRoot;
+        BtcId parentRoot;
+    };
+
+    // Records every successful union with the index of the day which caused it,
+    // so the clustering as known at the end of any day can be replayed later.
+    class VersionedQuickUnion {
     public:
-        using ForEachFunc = std::function<void(BtcId, BtcSize)>;
+        VersionedQuickUnion(
+            BtcSize idCount,
+            const std::filesystem::path& logPath,
+            const std::vector<std::string>& days
+        );
+
+        void beginDay(uint32_t dayIndex);
+        void connect(BtcId p, BtcId q);
+        void flush();
 
-        WeightedQuickUnionClusters(const WeightedQuickUnion& quickUnion);
+        const WeightedQuickUnion& getQuickUnion() const {
+            return _quickUnion;
+        }
 
-        void forEach(ForEachFunc handler) const;
+        uint64_t getLoggedUnionCount() const {
+            return _loggedUnionCount;
+        }
 
     private:
-        const WeightedQuickUnion& _quickUnion;
-    };
-
+        WeightedQuickUnion _quickUnion;
+        std::ofstream _logFile;
+        std::vector<UnionLogEntry> _logBuffer;
+        uint32_t _dayIndex;
+        uint64_t _loggedUnionCount;
+    };
+
+    class UnionLog {
+    public:
+        using MaterializeFunc = std::function<void(uint32_t, const WeightedQuickUnion&)>;
+
+        static const uint32_t NO_DAY = UINT32_MAX;
+
+        UnionLog(const std::filesystem::path& logPath);
+
+        uint32_t findDayIndex(const std::string& cutoffDay) const;
+        WeightedQuickUnion materialize(uint32_t cutoffDayIndex) const;
+        std::vector<BtcId> materializeRoots(uint32_t cutoffDayIndex) const;
+        void materialize(std::vector<uint32_t> cutoffDayIndexes, MaterializeFunc handler) const;
+
+        const std::vector<std::string>& getDays() const {
+            return _days;
+        }
+
+        BtcSize getIdCount() const {
+            return _idCount;
+        }
+
+    private:
+        std::filesystem::path _logPath;
+        std::vector<std::string> _days;
+        BtcSize _idCount;
+        std::streamoff _entriesOffset;
+    };
+
+    std::string getDayName(const std::string& dayDir);
+
     class ClusterLabels {
     public:
         bool isMiner;
@@ -0,0 +1,16 @@
+#include "btc_analyze_union_find/logger.h"
+
+LoggerType& getLogger() {
+    using logging::LoggerFactory;
+    using logging::Level;
+    using logging::handlers::StreamHandler;
+    using logging::handlers::FileHandler;
+    using logging::formatters::cstr::formatRecord;
+
+    static auto logger = LoggerFactory<Level::Debug>::createLogger("Analyze Union Find", std::make_tuple(
+        StreamHandler<Level::Debug>(formatRecord),
+        FileHandler<Level::Debug>::create("logs/btc_analyze_union_find.log", formatRecord)
+    ));
+
+    return logger;
+}
@@ -0,0 +1,275 @@
+// 统计聚类结果的实体大小分布、最大实体和树深度
+
+#include "btc-config.h"
+#include "btc_analyze_union_find/logger.h"
+
+#include "utils/mem_utils.h"
+#include "utils/task_utils.h"
+#include "utils/union_find.h"
+#include "fmt/format.h"
+#include <nlohmann/json.hpp>
+#include <argparse/argparse.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <bit>
+#include <algorithm>
+#include <functional>
+
+using json = nlohmann::json;
+using ClusterSizeRoot = std::pair<BtcId, BtcId>;
+
+// Bucket k holds clusters of [2^k, 2^(k+1)) addresses
+const size_t SIZE_BUCKET_COUNT = 64;
+
+struct UnionFindStatistics {
+    BtcId clusterCount = 0;
+    BtcId singletonCount = 0;
+    std::array<BtcId, SIZE_BUCKET_COUNT> bucketClusterCounts{};
+    std::array<BtcId, SIZE_BUCKET_COUNT> bucketIdCounts{};
+    uint64_t depthSum = 0;
+    std::vector<BtcId> depthCounts;
+    // Min heap of the largest clusters by size
+    std::vector<ClusterSizeRoot> topClusters;
+};
+
+static argparse::ArgumentParser createArgumentParser();
+
+UnionFindStatistics analyzeUnionFind(
+    const utils::btc::UnionFindView& quickUnion,
+    uint32_t workerCount,
+    uint32_t topCount
+);
+
+void analyzeIdRange(
+    const utils::btc::UnionFindView& quickUnion,
+    BtcId beginId,
+    BtcId endId,
+    uint32_t topCount,
+    UnionFindStatistics* statistics
+);
+
+void mergeStatistics(UnionFindStatistics& statistics, const UnionFindStatistics& rangeStatistics, uint32_t topCount);
+
+json generateReport(const utils::btc::UnionFindView& quickUnion, UnionFindStatistics& statistics);
+
+inline void logUsedMemory();
+
+auto& logger = getLogger();
+
+int main(int argc, char* argv[]) {
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
+    }
+
+    try {
+        uint32_t workerCount = std::min(
+            argumentParser.get<uint32_t>("--worker_count"),
+            std::thread::hardware_concurrency()
+        );
+        logger.info(fmt::format("Worker count: {}", workerCount));
+
+        std::string unionFindFilePath = argumentParser.get("uf_file");
+        utils::btc::UnionFindView quickUnion(unionFindFilePath);
+        logger.info(fmt::format("Mapped ids: {}, entities: {}", quickUnion.getSize(), quickUnion.getClusterCount()));
+
+        auto statistics = analyzeUnionFind(quickUnion, workerCount, argumentParser.get<uint32_t>("--top"));
+        logUsedMemory();
+
+        json report = generateReport(quickUnion, statistics);
+        report["file"] = unionFindFilePath;
+
+        std::string reportFilePath = argumentParser.get("report_file");
+        logger.info(fmt::format("Dump report to {}", reportFilePath));
+        std::ofstream reportFile(reportFilePath);
+        reportFile << report.dump(2) << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        logger.error(e.what());
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_analyze_union_find");
+
+    program.add_argument("uf_file")
+        .required()
+        .help("The union find file path");
+
+    program.add_argument("report_file")
+        .required()
+        .help("Output file path of the json report");
+
+    program.add_argument("--top")
+        .help("Number of largest clusters in the report")
+        .scan<'d', uint32_t>()
+        .default_value(20u);
+
+    program.add_argument("-w", "--worker_count")
+        .help("Max worker count")
+        .scan<'d', uint32_t>()
+        .required();
+
+    return program;
+}
+
+UnionFindStatistics analyzeUnionFind(
+    const utils::btc::UnionFindView& quickUnion,
+    uint32_t workerCount,
+    uint32_t topCount
+) {
+    UnionFindStatistics statistics;
+    std::mutex statisticsMutex;
+
+    utils::runRangesInParallel(quickUnion.getSize(), workerCount, [&](BtcId beginId, BtcId endId) {
+        UnionFindStatistics rangeStatistics;
+        analyzeIdRange(quickUnion, beginId, endId, topCount, &rangeStatistics);
+
+        std::lock_guard<std::mutex> statisticsLock(statisticsMutex);
+        mergeStatistics(statistics, rangeStatistics, topCount);
+        logger.info(fmt::format("Analyzed ids [{}, {})", beginId, endId));
+    });
+
+    return statistics;
+}
+
+void analyzeIdRange(
+    const utils::btc::UnionFindView& quickUnion,
+    BtcId beginId,
+    BtcId endId,
+    uint32_t topCount,
+    UnionFindStatistics* statistics
+) {
+    for (BtcId addressId = beginId; addressId != endId; ++addressId) {
+        // 深度为到根节点的边数，根节点为0
+        BtcId depth = 0;
+        for (BtcId id = addressId; quickUnion.getParent(id) != id; id = quickUnion.getParent(id)) {
+            ++depth;
+        }
+
+        if (depth >= statistics->depthCounts.size()) {
+            statistics->depthCounts.resize(depth + 1, 0);
+        }
+        ++statistics->depthCounts[depth];
+        statistics->depthSum += depth;
+
+        if (depth) {
+            continue;
+        }
+
+        // 根节点的大小至少为1，为0时bit_width - 1会越界
+        BtcId clusterSize = quickUnion.getClusterSize(addressId);
+        if (!clusterSize) {
+            throw std::runtime_error(fmt::format("Root {} has cluster size 0, the union find file is corrupted", addressId));
+        }
+        ++statistics->clusterCount;
+        if (clusterSize == 1) {
+            ++statistics->singletonCount;
+        }
+
+        auto bucketIndex = std::bit_width(clusterSize) - 1;
+        ++statistics->bucketClusterCounts[bucketIndex];
+        statistics->bucketIdCounts[bucketIndex] += clusterSize;
+
+        auto& topClusters = statistics->topClusters;
+        if (topClusters.size() < topCount) {
+            topClusters.push_back(std::make_pair(clusterSize, addressId));
+            std::push_heap(topClusters.begin(), topClusters.end(), std::greater<ClusterSizeRoot>());
+        }
+        else if (topCount && clusterSize > topClusters.front().first) {
+            std::pop_heap(topClusters.begin(), topClusters.end(), std::greater<ClusterSizeRoot>());
+            topClusters.back() = std::make_pair(clusterSize, addressId);
+            std::push_heap(topClusters.begin(), topClusters.end(), std::greater<ClusterSizeRoot>());
+        }
+    }
+}
+
+void mergeStatistics(UnionFindStatistics& statistics, const UnionFindStatistics& rangeStatistics, uint32_t topCount) {
+    statistics.clusterCount += rangeStatistics.clusterCount;
+    statistics.singletonCount += rangeStatistics.singletonCount;
+    for (size_t bucketIndex = 0; bucketIndex != SIZE_BUCKET_COUNT; ++bucketIndex) {
+        statistics.bucketClusterCounts[bucketIndex] += rangeStatistics.bucketClusterCounts[bucketIndex];
+        statistics.bucketIdCounts[bucketIndex] += rangeStatistics.bucketIdCounts[bucketIndex];
+    }
+
+    statistics.depthSum += rangeStatistics.depthSum;
+    if (statistics.depthCounts.size() < rangeStatistics.depthCounts.size()) {
+        statistics.depthCounts.resize(rangeStatistics.depthCounts.size(), 0);
+    }
+    for (size_t depth = 0; depth != rangeStatistics.depthCounts.size(); ++depth) {
+        statistics.depthCounts[depth] += rangeStatistics.depthCounts[depth];
+    }
+
+    auto& topClusters = statistics.topClusters;
+    topClusters.insert(topClusters.end(), rangeStatistics.topClusters.cbegin(), rangeStatistics.topClusters.cend());
+    std::sort(topClusters.begin(), topClusters.end(), std::greater<ClusterSizeRoot>());
+    if (topClusters.size() > topCount) {
+        topClusters.resize(topCount);
+    }
+    std::make_heap(topClusters.begin(), topClusters.end(), std::greater<ClusterSizeRoot>());
+}
+
+json generateReport(const utils::btc::UnionFindView& quickUnion, UnionFindStatistics& statistics) {
+    json report;
+
+    BtcId idCount = quickUnion.getSize();
+    report["idCount"] = idCount;
+    report["clusterCount"] = statistics.clusterCount;
+    report["singletonCount"] = statistics.singletonCount;
+    report["multiAddressClusterCount"] = statistics.clusterCount - statistics.singletonCount;
+    report["averageClusterSize"] = statistics.clusterCount ? double(idCount) / statistics.clusterCount : 0.0;
+
+    json sizeHistogram = json::array();
+    for (size_t bucketIndex = 0; bucketIndex != SIZE_BUCKET_COUNT; ++bucketIndex) {
+        if (!statistics.bucketClusterCounts[bucketIndex]) {
+            continue;
+        }
+
+        sizeHistogram.push_back({
+            {"minSize", uint64_t(1) << bucketIndex},
+            {"maxSize", (uint64_t(1) << bucketIndex) * 2 - 1},
+            {"clusterCount", statistics.bucketClusterCounts[bucketIndex]},
+            {"idCount", statistics.bucketIdCounts[bucketIndex]}
+        });
+    }
+    report["sizeHistogram"] = sizeHistogram;
+
+    report["depth"] = {
+        {"max", statistics.depthCounts.size() ? statistics.depthCounts.size() - 1 : 0},
+        {"average", idCount ? double(statistics.depthSum) / idCount : 0.0},
+        {"idCounts", statistics.depthCounts}
+    };
+
+    auto& topClusters = statistics.topClusters;
+    std::sort(topClusters.begin(), topClusters.end(), std::greater<ClusterSizeRoot>());
+
+    json topClusterItems = json::array();
+    for (const auto& [clusterSize, rootId] : topClusters) {
+        topClusterItems.push_back({{"root", rootId}, {"size", clusterSize}});
+    }
+    report["topClusters"] = topClusterItems;
+
+    return report;
+}
+
+inline void logUsedMemory() {
+    auto usedMemory = utils::mem::getAllocatedMemory();
+    logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
+}
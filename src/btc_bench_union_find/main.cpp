@@ -0,0 +1,154 @@
+// 比较内存与外存并查集的速度
+
+#include "btc-config.h"
+#include "btc_bench_union_find/logger.h"
+
+#include "utils/mem_utils.h"
+#include "utils/union_find.h"
+#include "fmt/format.h"
+#include <argparse/argparse.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+using utils::btc::BtcSize;
+
+using Edge = std::pair<BtcId, BtcId>;
+
+static argparse::ArgumentParser createArgumentParser();
+std::vector<Edge> generateEdges(BtcSize idCount, uint64_t edgeCount, uint64_t seed);
+
+template <typename QuickUnion>
+double benchQuickUnion(QuickUnion& quickUnion, const std::vector<Edge>& edges);
+
+inline void logUsedMemory();
+
+auto& logger = getLogger();
+
+int main(int argc, char* argv[]) {
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
+    }
+
+    try {
+        BtcSize idCount = argumentParser.get<BtcId>("--id_count");
+        uint64_t edgeCount = argumentParser.get<uint64_t>("--edge_count");
+        uint32_t edgeBufferMb = argumentParser.get<uint32_t>("--edge_buffer_mb");
+
+        logger.info(fmt::format("Generate {} random edges over {} ids", edgeCount, idCount));
+        const auto& edges = generateEdges(idCount, edgeCount, argumentParser.get<uint64_t>("--seed"));
+        logUsedMemory();
+
+        double weightedSeconds = 0;
+        {
+            utils::btc::WeightedQuickUnion quickUnion(idCount);
+            weightedSeconds = benchQuickUnion(quickUnion, edges);
+            logger.info(fmt::format("Weighted in RAM: {:.3f}s, entities: {}", weightedSeconds, quickUnion.getClusterCount()));
+        }
+
+        {
+            utils::btc::RankedQuickUnion quickUnion(idCount);
+            double seconds = benchQuickUnion(quickUnion, edges);
+            logger.info(fmt::format(
+                "Ranked in RAM: {:.3f}s ({:.2f}x), entities: {}",
+                seconds, seconds / weightedSeconds, quickUnion.getClusterCount()
+            ));
+        }
+
+        std::string workFilePath = argumentParser.get("--work_file");
+        {
+            std::size_t edgeBufferCount = std::size_t(edgeBufferMb) * 1024 * 1024 / sizeof(Edge);
+            utils::btc::ExternalQuickUnion quickUnion(workFilePath, idCount, edgeBufferCount);
+            double seconds = benchQuickUnion(quickUnion, edges);
+
+            auto startTime = std::chrono::steady_clock::now();
+            quickUnion.close(std::vector<std::string>());
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            logger.info(fmt::format(
+                "External with {}MB edge buffer: {:.3f}s ({:.2f}x), entities: {}",
+                edgeBufferMb, seconds, seconds / weightedSeconds, quickUnion.getClusterCount()
+            ));
+        }
+        fs::remove(workFilePath);
+
+        logUsedMemory();
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        logger.error(e.what());
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_bench_union_find");
+
+    program.add_argument("--id_count")
+        .help("Address id count")
+        .scan<'d', BtcId>()
+        .default_value(BtcId(10000000));
+
+    program.add_argument("--edge_count")
+        .help("Random edge count")
+        .scan<'d', uint64_t>()
+        .default_value(uint64_t(20000000));
+
+    program.add_argument("--edge_buffer_mb")
+        .help("Edge batch buffer of the external union find")
+        .scan<'d', uint32_t>()
+        .default_value(16u);
+
+    program.add_argument("--work_file")
+        .help("Mapped file of the external union find, removed afterwards")
+        .default_value("bench_union_find.uf");
+
+    program.add_argument("--seed")
+        .help("Random seed")
+        .scan<'d', uint64_t>()
+        .default_value(uint64_t(42));
+
+    return program;
+}
+
+std::vector<Edge> generateEdges(BtcSize idCount, uint64_t edgeCount, uint64_t seed) {
+    std::mt19937_64 generator(seed);
+    std::uniform_int_distribution<BtcId> distribution(0, idCount - 1);
+
+    std::vector<Edge> edges;
+    edges.reserve(edgeCount);
+    for (uint64_t edgeIndex = 0; edgeIndex != edgeCount; ++edgeIndex) {
+        edges.emplace_back(distribution(generator), distribution(generator));
+    }
+
+    return edges;
+}
+
+template <typename QuickUnion>
+double benchQuickUnion(QuickUnion& quickUnion, const std::vector<Edge>& edges) {
+    auto startTime = std::chrono::steady_clock::now();
+    for (const auto& [p, q] : edges) {
+        quickUnion.connect(p, q);
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+inline void logUsedMemory() {
+    auto usedMemory = utils::mem::getAllocatedMemory();
+    logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
+}
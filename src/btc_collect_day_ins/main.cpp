@@ -8,7 +8,10 @@
 #include "utils/json_utils.h"
 #include "utils/mem_utils.h"
 #include "utils/btc_utils.h"
+#include "utils/day_inputs.h"
+#include "utils/id_bitset.h"
 #include "fmt/format.h"
+#include <argparse/argparse.hpp>
 
 #include <cstdlib>
 #include <iostream>
@@ -25,19 +28,23 @@ using json = nlohmann::json;
 
 namespace fs = std::filesystem;
 
+static argparse::ArgumentParser createArgumentParser();
+
 void getInputBtcIdOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    std::set<BtcId>* addresses
+    std::string dayInputsFileName,
+    utils::btc::IdBitset* addresses
 );
 
 void getInputBtcIdOfDay(
     const std::string& dayDir,
-    std::set<BtcId>& addresses
+    const std::string& dayInputsFileName,
+    utils::btc::IdBitset& addresses
 );
 
-void mergeInputBtcIds(
-    std::vector<std::set<BtcId>>& tasksUniqueAddresses
+utils::btc::IdBitset mergeInputBtcIds(
+    std::vector<utils::btc::IdBitset>& tasksUniqueAddresses
 );
 
 inline void logUsedMemory();
@@ -45,51 +52,87 @@ inline void logUsedMemory();
 auto& logger = getLogger();
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Invalid arguments!\n\nUsage: btc_collect_day_ins <days_dir_list>\n" << std::endl;
-
-        return EXIT_FAILURE;
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
     }
 
-    const char* daysListFilePath = argv[1];
+    std::string daysListFilePath = argumentParser.get("days_dir_list");
+    std::string dayInputsFileName = argumentParser.get("--day_ins_file");
     logger.info(fmt::format("Read tasks form {}", daysListFilePath));
 
     const std::vector<std::string>& daysList = utils::readLines(daysListFilePath);
     logger.info(fmt::format("Read tasks count: {}", daysList.size()));
 
-    uint32_t workerCount = std::min(BTC_COLLECT_DAY_INS_WORKER_COUNT, std::thread::hardware_concurrency());
+    uint32_t workerCount = std::min(argumentParser.get<uint32_t>("--worker_count"), std::thread::hardware_concurrency());
     logger.info(fmt::format("Hardware Concurrency: {}", std::thread::hardware_concurrency()));
     logger.info(fmt::format("Worker count: {}", workerCount));
 
     const std::vector<std::vector<std::string>> taskChunks = utils::generateTaskChunks(daysList, workerCount);
-    std::vector<std::set<BtcId>> tasksUniqueAddresses(workerCount);
+    std::vector<utils::btc::IdBitset> tasksUniqueAddresses(workerCount);
 
     uint32_t workerIndex = 0;
     std::vector<std::future<void>> tasks;
     for (const auto& taskChunk : taskChunks) {
         auto& taskUniqueeAddresses = tasksUniqueAddresses[workerIndex];
         tasks.push_back(
-            std::async(getInputBtcIdOfDays, workerIndex, &taskChunk, &taskUniqueeAddresses)
+            std::async(getInputBtcIdOfDays, workerIndex, &taskChunk, dayInputsFileName, &taskUniqueeAddresses)
         );
 
         ++workerIndex;
     }
     utils::waitForTasks(logger, tasks);
 
-    mergeInputBtcIds(tasksUniqueAddresses);
+    auto inputAddresses = mergeInputBtcIds(tasksUniqueAddresses);
+    logUsedMemory();
+
+    std::string bitmapFilePath = argumentParser.get("--bitmap");
+    if (!bitmapFilePath.empty()) {
+        logger.info(fmt::format("Dump input addresses bitmap to {}", bitmapFilePath));
+        inputAddresses.save(bitmapFilePath);
+    }
 
     return EXIT_SUCCESS;
 }
 
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_collect_day_ins");
+
+    program.add_argument("days_dir_list")
+        .required()
+        .help("List file path of days directories");
+
+    program.add_argument("--day_ins_file")
+        .help("Filename of day inputs address file, .bin files are read as binary day inputs")
+        .default_value("day-inputs.json");
+
+    program.add_argument("--bitmap")
+        .help("Output file path of the bitmap of all input addresses")
+        .default_value("");
+
+    program.add_argument("-w", "--worker_count")
+        .help("Max worker count")
+        .scan<'d', uint32_t>()
+        .default_value(BTC_COLLECT_DAY_INS_WORKER_COUNT);
+
+    return program;
+}
+
 void getInputBtcIdOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysList,
-    std::set<BtcId>* addresses
+    std::string dayInputsFileName,
+    utils::btc::IdBitset* addresses
 ) {
     logger.info(fmt::format("Worker started: {}", workerIndex));
 
     for (const auto& dayDir : *daysList) {
-        getInputBtcIdOfDay(dayDir, *addresses);
+        getInputBtcIdOfDay(dayDir, dayInputsFileName, *addresses);
         auto usedMemory = utils::mem::getAllocatedMemory();
         logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
     }
@@ -97,10 +140,24 @@ void getInputBtcIdOfDays(
 
 void getInputBtcIdOfDay(
     const std::string& dayDir,
-    std::set<BtcId>& addresses
+    const std::string& dayInputsFileName,
+    utils::btc::IdBitset& addresses
 ) {
     try {
-        auto txInputsOfDayFilePath = fmt::format("{}/{}", dayDir, "day-inputs.json");
+        auto txInputsOfDayFilePath = fmt::format("{}/{}", dayDir, dayInputsFileName);
+        if (utils::btc::isBinaryDayInputsPath(txInputsOfDayFilePath)) {
+            utils::btc::DayInputsView txInputsOfDay(txInputsOfDayFilePath);
+            txInputsOfDay.forEachTx([&addresses](std::span<const BtcId> inputs) {
+                for (const auto input : inputs) {
+                    addresses.insert(input);
+                }
+            });
+
+            logger.info(fmt::format("Finished process blocks by date: {}", dayDir));
+
+            return;
+        }
+
         std::vector<std::vector<std::vector<BtcId>>> txInputsOfDay;
         utils::btc::loadDayInputs(txInputsOfDayFilePath.c_str(), txInputsOfDay);
 
@@ -127,22 +184,26 @@ void getInputBtcIdOfDay(
     }
 }
 
-void mergeInputBtcIds(
-    std::vector<std::set<BtcId>>& tasksUniqueAddresses
+utils::btc::IdBitset mergeInputBtcIds(
+    std::vector<utils::btc::IdBitset>& tasksUniqueAddresses
 ) {
-    std::set<BtcId> finalAddressSet;
+    utils::btc::IdBitset finalAddressSet;
     size_t totalAddressCount = 0;
     while (tasksUniqueAddresses.size()) {
         const auto& taskUniqueAddresses = tasksUniqueAddresses.back();
-        logger.info(fmt::format("Generated task unique addresses: {}", taskUniqueAddresses.size()));
-        totalAddressCount += taskUniqueAddresses.size();
+        auto taskAddressCount = taskUniqueAddresses.count();
+        logger.info(fmt::format("Generated task unique addresses: {}", taskAddressCount));
+        totalAddressCount += taskAddressCount;
 
-        finalAddressSet.insert(taskUniqueAddresses.cbegin(), taskUniqueAddresses.cend());
+        finalAddressSet |= taskUniqueAddresses;
         tasksUniqueAddresses.pop_back();
     }
 
-    logger.info(fmt::format("Final unique addresses: {}/{}", finalAddressSet.size(), totalAddressCount));
-    logger.info(fmt::format("Remove duplicated addresses: {}", totalAddressCount - finalAddressSet.size()));
+    auto finalAddressCount = finalAddressSet.count();
+    logger.info(fmt::format("Final unique addresses: {}/{}", finalAddressCount, totalAddressCount));
+    logger.info(fmt::format("Remove duplicated addresses: {}", totalAddressCount - finalAddressCount));
+
+    return finalAddressSet;
 }
 
 inline void logUsedMemory() {
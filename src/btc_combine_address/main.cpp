@@ -5,6 +5,9 @@
 #include "logging/handlers/FileHandler.h"
 #include "utils/io_utils.h"
 #include "utils/btc_utils.h"
+#include "utils/sorted_merge.h"
+#include "utils/address_index.h"
+#include "utils/id2address.h"
 #include "fmt/format.h"
 
 #include <cstdlib>
@@ -19,36 +22,69 @@ namespace fs = std::filesystem;
 
 void combineBlocksOfDays(uint32_t workerIndex, const std::vector<std::string>& daysList);
 void combineBlocksFromList(const fs::path& dayDirPath);
+uint64_t combineFirstSeenFiles(const std::string& combinedFilePath, const std::vector<std::string>& id2addrFilePaths);
 
 auto& logger = getLogger();
 
 int main(int32_t argc, char* argv[]) {
+    // btc_gen_address --order first_seen 生成的id2addr没有排序，按输入顺序拼接去重
+    bool firstSeenOrder = argc > 1 && std::string(argv[1]) == "--first_seen";
+    if (firstSeenOrder) {
+        --argc;
+        ++argv;
+    }
+
     if (argc < 3) {
-        std::cerr << "Invalid arguments!\n\nUsage: btc_combine_address <combined_id2addr> <id2addrs>\n" << std::endl;
+        std::cerr << "Invalid arguments!\n\nUsage: btc_combine_address [--first_seen] <combined_id2addr> <id2addrs>\n\n"
+            "Inputs are sorted id2addrs by default. With --first_seen they are first_seen id2addrs in day order,\n"
+            "the addresses of the first file keep their ids and new addresses of later files are appended.\n" << std::endl;
 
         return EXIT_FAILURE;
     }
     
     try {
-        std::set<std::string> id2Addr;
-        int32_t inputFileCount = argc - 2;
-        logger.info(fmt::format("List file count: {}", inputFileCount));
-        for (int32_t inputFileIndex = 0; inputFileIndex != inputFileCount; ++inputFileIndex) {
-            const char* id2addrFilePath = argv[inputFileIndex + 2];
+        std::vector<std::string> id2addrFilePaths(argv + 2, argv + argc);
+        logger.info(fmt::format("List file count: {}", id2addrFilePaths.size()));
+        for (const auto& id2addrFilePath : id2addrFilePaths) {
             logger.info(fmt::format("Merge id2addr form {}", id2addrFilePath));
-
-            utils::readLines(id2addrFilePath, id2Addr);
         }
-        logger.info(fmt::format("Merge address count: {}", id2Addr.size()));
 
         const char* combinedFilePath = argv[1];
-        logger.info(fmt::format("Dump merged file to: {}", combinedFilePath));
-        utils::btc::dumpId2Address(combinedFilePath, id2Addr);
+        logger.info(fmt::format("Merge to file: {}", combinedFilePath));
+        if (firstSeenOrder) {
+            auto addressCount = combineFirstSeenFiles(combinedFilePath, id2addrFilePaths);
+            logger.info(fmt::format("Merge address count: {}", addressCount));
+
+            return EXIT_SUCCESS;
+        }
+
+        // 输入的id2addr均已按字典序排序，直接流式归并去重
+        auto addressCount = utils::mergeSortedUniqueFiles(combinedFilePath, id2addrFilePaths);
+        logger.info(fmt::format("Merge address count: {}", addressCount));
     }
     catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
         logger.error(e.what());
+
+        return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+uint64_t combineFirstSeenFiles(const std::string& combinedFilePath, const std::vector<std::string>& id2addrFilePaths) {
+    utils::btc::AddressIndex address2Id;
+    for (const auto& id2addrFilePath : id2addrFilePaths) {
+        // Stops at the first empty line, so addresses are numbered like every other id2addr reader
+        utils::btc::Id2AddressView id2Address(id2addrFilePath);
+        for (BtcId addressId = 0; addressId != id2Address.size(); ++addressId) {
+            address2Id.insert(id2Address.getAddress(addressId));
+        }
+        logger.info(fmt::format("Combined {}, address count: {}", id2addrFilePath, address2Id.size()));
+    }
+
+    fs::remove(combinedFilePath);
+    address2Id.appendToFile(combinedFilePath, 0);
+
+    return address2Id.size();
+}
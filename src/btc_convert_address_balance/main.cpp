@@ -3,6 +3,7 @@
 
 #include "logging/Logger.h"
 #include "utils/io_utils.h"
+#include "utils/line_loader.h"
 #include "utils/task_utils.h"
 #include "utils/btc_utils.h"
 #include "utils/mem_utils.h"
@@ -172,29 +173,15 @@ std::size_t loadBalanceList(
     BalanceList& balanceList
 ) {
     logger.info(fmt::format("Load balance from: {}", inputFilePath));
-    std::ifstream inputFile(inputFilePath.c_str());
-    std::size_t loadedCount = 0;
 
-    while (inputFile) {
-        std::string line;
-        std::getline(inputFile, line);
-
-        auto seperatorPos = line.find(',');
-        if (seperatorPos == std::string::npos) {
-            continue;
+    // 文件已经分给多个worker并行处理，每个文件只用一个线程加载
+    return utils::forEachIdValueLine<BtcId, BalanceValue>(inputFilePath, [&](BtcId btcId, BalanceValue btcValue) {
+        if (btcId >= balanceList.size()) {
+            throw std::runtime_error(fmt::format("Address id {} of {} is out of range", btcId, inputFilePath));
         }
 
-        std::string btcIdString = line.substr(0, seperatorPos);
-        std::string balanceString = line.substr(seperatorPos + 1);
-
-        BtcId btcId = std::stoll(btcIdString);
-        BalanceValue btcValue = std::stod(balanceString);
-
         balanceList[btcId] = btcValue;
-        ++ loadedCount;
-    }
-
-    return loadedCount;
+    }, 1);
 }
 
 void dumpBalanceList(
@@ -8,8 +8,10 @@
 #include "utils/json_utils.h"
 #include "utils/btc_utils.h"
 #include "utils/mem_utils.h"
+#include "utils/address_index.h"
 #include "fmt/format.h"
 #include <nlohmann/json.hpp>
+#include <argparse/argparse.hpp>
 
 #include <cstdlib>
 #include <iostream>
@@ -26,29 +28,59 @@ using json = nlohmann::json;
 
 namespace fs = std::filesystem;
 
+static argparse::ArgumentParser createArgumentParser();
+
+// AddressIdFunc returns the id of an address, or AddressIndex::NO_ID to keep the address string.
+// Addresses that are ids already are left as they are.
+template <class AddressIdFunc>
+void convertBlocksOfTasks(
+    const std::vector<std::vector<std::string>>& taskChunks,
+    const AddressIdFunc& getAddressId,
+    bool skipExisted
+);
+
+template <class AddressIdFunc>
 void convertBlocksOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const std::map<std::string, BtcId>* address2Id,
+    const AddressIdFunc* getAddressId,
     bool skipExisted
 );
 
+template <class AddressIdFunc>
 void convertBlocksOfDay(
     const std::string& dayDir,
-    const std::map<std::string, BtcId>& address2Id,
+    const AddressIdFunc& getAddressId,
+    bool skipExisted
+);
+
+void internBlocksOfDays(
+    const std::vector<std::string>& daysList,
+    uint32_t workerCount,
+    utils::btc::AddressIndex& address2Id,
+    const std::string& id2AddressFilePath,
     bool skipExisted
 );
 
+bool loadBlocksOfDay(const std::string& dayDir, bool skipExisted, json* blocks);
+
+void saveConvertedBlocksOfDay(const std::string& dayDir, const json& blocks);
+
+template <class AddressIdFunc>
+void convertAddressesOfBlocks(const std::string& dayDir, json& blocks, const AddressIdFunc& getAddressId);
+
+template <class AddressIdFunc>
 inline std::vector<std::vector<BtcId>> convertAddressesOfBlock(
     const std::string& dayDir,
     json& block,
-    const std::map<std::string, BtcId>& address2Id
+    const AddressIdFunc& getAddressId
 );
 
+template <class AddressIdFunc>
 inline void convertAddressesOfTx(
     const std::string& dayDir,
     json& tx,
-    const std::map<std::string, BtcId>& address2Id
+    const AddressIdFunc& getAddressId
 );
 
 inline void logUsedMemory();
@@ -56,13 +88,17 @@ inline void logUsedMemory();
 auto& logger = getLogger();
 
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Invalid arguments!\n\nUsage: btc_convert_blocks <days_dir_list> <id2addr> <skip_existed>\n" << std::endl;
-
-        return EXIT_FAILURE;
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
     }
 
-    const char* daysListFilePath = argv[1];
+    std::string daysListFilePath = argumentParser.get("days_dir_list");
     logger.info(fmt::format("Read tasks form {}", daysListFilePath));
 
     const std::vector<std::string>& daysList = utils::readLines(daysListFilePath);
@@ -74,100 +110,277 @@ int main(int argc, char* argv[]) {
 
     logUsedMemory();
 
-    const char* id2AddressFilePath = argv[2];
+    const std::vector<std::vector<std::string>> taskChunks = utils::generateTaskChunks(daysList, workerCount);
+
+    logUsedMemory();
+
+    bool skipExisted = argumentParser.get("skip_existed") == "true";
+    std::string id2AddressFilePath = argumentParser.get("id2addr");
+    bool appendAddresses = argumentParser.get<bool>("--append");
+    if (appendAddresses && !argumentParser.get<bool>("--intern")) {
+        logger.error("--append only works with --intern");
+
+        return EXIT_FAILURE;
+    }
+
+    if (argumentParser.get<bool>("--intern")) {
+        // 转换时直接为首次出现的地址分配id，省去btc_gen_address的一次全量扫描
+        // --append时已有地址保持原id，新地址追加到id2addr末尾，已转换的天可以跳过
+        if (skipExisted && !appendAddresses) {
+            logger.error("Can't skip existed days when interning, their addresses would get no id");
+
+            return EXIT_FAILURE;
+        }
+
+        utils::btc::AddressIndex address2Id;
+        if (!appendAddresses) {
+            // Without --append the file is written from scratch
+            fs::remove(id2AddressFilePath);
+        } else if (fs::exists(id2AddressFilePath)) {
+            logger.info(fmt::format("Load address2Id from {}", id2AddressFilePath));
+            address2Id = utils::btc::AddressIndex::load(id2AddressFilePath);
+            logger.info(fmt::format("Loaded address2Id: {} items", address2Id.size()));
+            logUsedMemory();
+        }
+        BtcId firstNewId = address2Id.size();
+
+        internBlocksOfDays(daysList, workerCount, address2Id, id2AddressFilePath, skipExisted);
+        logger.info(fmt::format("Interned addresses: {}, new: {}", address2Id.size(), address2Id.size() - firstNewId));
+        logUsedMemory();
+
+        return EXIT_SUCCESS;
+    }
+
     logger.info("Load address2Id...");
-    const auto& address2Id = utils::btc::loadAddress2Id(id2AddressFilePath);
+    const auto& address2Id = utils::btc::AddressIndex::load(id2AddressFilePath);
     logger.info(fmt::format("Loaded address2Id: {} items", address2Id.size()));
 
     logUsedMemory();
 
-    const std::vector<std::vector<std::string>> taskChunks = utils::generateTaskChunks(daysList, workerCount);
+    auto findAddress = [&address2Id](const std::string& address) -> BtcId {
+        return address2Id.find(address);
+    };
+    convertBlocksOfTasks(taskChunks, findAddress, skipExisted);
 
-    logUsedMemory();
+    return EXIT_SUCCESS;
+}
 
-    bool skipExisted = false;
-    if (argc == 4) {
-        std::string skipExistedStr = argv[3];
-        skipExisted = skipExistedStr == "true";
-    }
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_convert_blocks");
 
+    program.add_argument("days_dir_list")
+        .required()
+        .help("List file path of days directories");
+
+    program.add_argument("id2addr")
+        .required()
+        .help("The file path of id2addr, with --intern new addresses are appended before their days are saved");
+
+    program.add_argument("skip_existed")
+        .help("true to skip days already converted")
+        .nargs(argparse::nargs_pattern::optional)
+        .default_value(std::string("false"));
+
+    program.add_argument("--intern")
+        .help("Assign ids to addresses on first sight while converting instead of reading id2addr. "
+            "Ids follow days_dir_list order like btc_gen_address --order first_seen, so id2addr isn't sorted")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--append")
+        .help("With --intern, keep the ids of an existing id2addr and append new addresses to it")
+        .default_value(false)
+        .implicit_value(true);
+
+    return program;
+}
+
+template <class AddressIdFunc>
+void convertBlocksOfTasks(
+    const std::vector<std::vector<std::string>>& taskChunks,
+    const AddressIdFunc& getAddressId,
+    bool skipExisted
+) {
     uint32_t workerIndex = 0;
     std::vector<std::future<void>> tasks;
     for (const auto& taskChunk : taskChunks) {
         tasks.push_back(
-            std::async(convertBlocksOfDays, workerIndex, &taskChunk, &address2Id, skipExisted)
+            std::async(convertBlocksOfDays<AddressIdFunc>, workerIndex, &taskChunk, &getAddressId, skipExisted)
         );
 
         ++workerIndex;
     }
     utils::waitForTasks(logger, tasks);
-
-    return EXIT_SUCCESS;
 }
 
+template <class AddressIdFunc>
 void convertBlocksOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysList,
-    const std::map<std::string, BtcId>* address2Id,
+    const AddressIdFunc* getAddressId,
     bool skipExisted
 ) {
     logger.info(fmt::format("Worker started: {}", workerIndex));
 
     for (const auto& dayDir : *daysList) {
-        convertBlocksOfDay(dayDir, *address2Id, skipExisted);
+        convertBlocksOfDay(dayDir, *getAddressId, skipExisted);
     }
 }
 
+template <class AddressIdFunc>
 void convertBlocksOfDay(
     const std::string& dayDir,
-    const std::map<std::string, BtcId>& address2Id,
+    const AddressIdFunc& getAddressId,
     bool skipExisted
 ) {
     try {
-        auto convertedBlocksListFilePath = fmt::format("{}/{}", dayDir, "converted-block-list.json");
-        if (skipExisted && fs::exists(convertedBlocksListFilePath)) {
-            logger.info(fmt::format("Skip existed blocks by date: {}", dayDir));
-
+        json blocks;
+        if (!loadBlocksOfDay(dayDir, skipExisted, &blocks)) {
             return;
         }
 
-        auto combinedBlocksFilePath = fmt::format("{}/{}", dayDir, "combined-block-list.json");
-        logger.info(fmt::format("Process combined blocks file: {}", dayDir));
+        convertAddressesOfBlocks(dayDir, blocks, getAddressId);
+        saveConvertedBlocksOfDay(dayDir, blocks);
+    }
+    catch (const std::exception& e) {
+        logger.error(fmt::format("Error when process blocks by date: {}", dayDir));
+        logger.error(e.what());
+    }
+}
 
-        std::ifstream combinedBlocksFile(combinedBlocksFilePath.c_str());
-        if (!combinedBlocksFile.is_open()) {
-            logger.warning(fmt::format("Finished process blocks by date because file not exists: {}", combinedBlocksFilePath));
-            return;
-        }
+void internBlocksOfDays(
+    const std::vector<std::string>& daysList,
+    uint32_t workerCount,
+    utils::btc::AddressIndex& address2Id,
+    const std::string& id2AddressFilePath,
+    bool skipExisted
+) {
+    // Days are converted workerCount at a time. Known addresses are converted at once and the new ones
+    // of each day are collected, then they get ids day by day in list order, so ids don't depend on
+    // worker timing. id2addr is appended before the days are saved, a saved day never has unknown ids.
+    for (size_t windowBegin = 0; windowBegin < daysList.size(); windowBegin += workerCount) {
+        size_t windowSize = std::min<size_t>(workerCount, daysList.size() - windowBegin);
+
+        std::vector<json> windowBlocks(windowSize);
+        std::vector<utils::btc::AddressIndex> windowNewAddresses(windowSize);
+        std::vector<char> windowLoaded(windowSize, false);
+        utils::runRangesInParallel(windowSize, workerCount, [&](uint64_t dayBegin, uint64_t dayEnd) {
+            for (uint64_t dayIndex = dayBegin; dayIndex != dayEnd; ++dayIndex) {
+                const auto& dayDir = daysList[windowBegin + dayIndex];
+                try {
+                    if (!loadBlocksOfDay(dayDir, skipExisted, &windowBlocks[dayIndex])) {
+                        continue;
+                    }
+
+                    // address2Id is only read while the window is converted
+                    auto& newAddresses = windowNewAddresses[dayIndex];
+                    auto findOrCollectAddress = [&address2Id, &newAddresses](const std::string& address) -> BtcId {
+                        BtcId addressId = address2Id.find(address);
+                        if (addressId == utils::btc::AddressIndex::NO_ID) {
+                            newAddresses.insert(address);
+                        }
+
+                        return addressId;
+                    };
+                    convertAddressesOfBlocks(dayDir, windowBlocks[dayIndex], findOrCollectAddress);
+                    windowLoaded[dayIndex] = true;
+                }
+                catch (const std::exception& e) {
+                    logger.error(fmt::format("Error when process blocks by date: {}", dayDir));
+                    logger.error(e.what());
+                }
+            }
+        });
 
-        logUsedMemory();
-        json blocks;
-        combinedBlocksFile >> blocks;
-        logger.info(fmt::format("Block count: {} {}", dayDir, blocks.size()));
-        logUsedMemory();
+        BtcId windowFirstId = address2Id.size();
+        for (size_t dayIndex = 0; dayIndex != windowSize; ++dayIndex) {
+            if (!windowLoaded[dayIndex]) {
+                continue;
+            }
 
-        for (auto& block : blocks) {
-            convertAddressesOfBlock(dayDir, block, address2Id);
+            const auto& newAddresses = windowNewAddresses[dayIndex];
+            for (BtcId localId = 0; localId != newAddresses.size(); ++localId) {
+                address2Id.insert(newAddresses.getAddress(localId));
+            }
         }
+        windowNewAddresses.clear();
+
+        logger.info(fmt::format("Append {} addresses to {}", address2Id.size() - windowFirstId, id2AddressFilePath));
+        address2Id.appendToFile(id2AddressFilePath, windowFirstId);
+
+        auto findAddress = [&address2Id](const std::string& address) -> BtcId {
+            return address2Id.find(address);
+        };
+        utils::runRangesInParallel(windowSize, workerCount, [&](uint64_t dayBegin, uint64_t dayEnd) {
+            for (uint64_t dayIndex = dayBegin; dayIndex != dayEnd; ++dayIndex) {
+                if (!windowLoaded[dayIndex]) {
+                    continue;
+                }
 
+                const auto& dayDir = daysList[windowBegin + dayIndex];
+                try {
+                    convertAddressesOfBlocks(dayDir, windowBlocks[dayIndex], findAddress);
+                    saveConvertedBlocksOfDay(dayDir, windowBlocks[dayIndex]);
+                }
+                catch (const std::exception& e) {
+                    logger.error(fmt::format("Error when process blocks by date: {}", dayDir));
+                    logger.error(e.what());
+                }
+            }
+        });
         logUsedMemory();
-        std::ofstream convertedBlocksFile(convertedBlocksListFilePath.c_str());
-        convertedBlocksFile << blocks;
+    }
+}
 
-        logger.info(fmt::format("Finished process blocks by date: {}", dayDir));
+bool loadBlocksOfDay(const std::string& dayDir, bool skipExisted, json* blocks) {
+    auto convertedBlocksListFilePath = fmt::format("{}/{}", dayDir, "converted-block-list.json");
+    if (skipExisted && fs::exists(convertedBlocksListFilePath)) {
+        logger.info(fmt::format("Skip existed blocks by date: {}", dayDir));
 
-        logUsedMemory();
+        return false;
     }
-    catch (const std::exception& e) {
-        logger.error(fmt::format("Error when process blocks by date: {}", dayDir));
-        logger.error(e.what());
+
+    auto combinedBlocksFilePath = fmt::format("{}/{}", dayDir, "combined-block-list.json");
+    logger.info(fmt::format("Process combined blocks file: {}", dayDir));
+
+    std::ifstream combinedBlocksFile(combinedBlocksFilePath.c_str());
+    if (!combinedBlocksFile.is_open()) {
+        logger.warning(fmt::format("Finished process blocks by date because file not exists: {}", combinedBlocksFilePath));
+        return false;
+    }
+
+    logUsedMemory();
+    combinedBlocksFile >> *blocks;
+    logger.info(fmt::format("Block count: {} {}", dayDir, blocks->size()));
+    logUsedMemory();
+
+    return true;
+}
+
+void saveConvertedBlocksOfDay(const std::string& dayDir, const json& blocks) {
+    auto convertedBlocksListFilePath = fmt::format("{}/{}", dayDir, "converted-block-list.json");
+
+    logUsedMemory();
+    std::ofstream convertedBlocksFile(convertedBlocksListFilePath.c_str());
+    convertedBlocksFile << blocks;
+
+    logger.info(fmt::format("Finished process blocks by date: {}", dayDir));
+
+    logUsedMemory();
+}
+
+template <class AddressIdFunc>
+void convertAddressesOfBlocks(const std::string& dayDir, json& blocks, const AddressIdFunc& getAddressId) {
+    for (auto& block : blocks) {
+        convertAddressesOfBlock(dayDir, block, getAddressId);
     }
 }
 
+template <class AddressIdFunc>
 inline std::vector<std::vector<BtcId>> convertAddressesOfBlock(
     const std::string& dayDir,
     json& block,
-    const std::map<std::string, BtcId>& address2Id
+    const AddressIdFunc& getAddressId
 ) {
     std::string blockHash = utils::json::get(block, "hash");
     std::vector<std::vector<BtcId>> inputIdsOfBlock;
@@ -176,7 +389,7 @@ inline std::vector<std::vector<BtcId>> convertAddressesOfBlock(
         auto& txs = block["tx"];
 
         for (auto& tx : txs) {
-            convertAddressesOfTx(dayDir, tx, address2Id);
+            convertAddressesOfTx(dayDir, tx, getAddressId);
         }
     }
     catch (std::exception& e) {
@@ -187,10 +400,11 @@ inline std::vector<std::vector<BtcId>> convertAddressesOfBlock(
     return inputIdsOfBlock;
 }
 
+template <class AddressIdFunc>
 inline void convertAddressesOfTx(
     const std::string& dayDir,
     json& tx,
-    const std::map<std::string, BtcId>& address2Id
+    const AddressIdFunc& getAddressId
 ) {
     std::string txHash = utils::json::get(tx, "hash");
 
@@ -204,12 +418,10 @@ inline void convertAddressesOfTx(
             auto& prevOut = prevOutItem.value();
 
             auto addrItem = prevOut.find("addr");
-            if (addrItem != prevOut.cend()) {
-                std::string address = addrItem.value();
-                auto addressIdItem = address2Id.find(address);
+            if (addrItem != prevOut.cend() && addrItem.value().is_string()) {
+                BtcId addressId = getAddressId(addrItem.value().get_ref<const std::string&>());
 
-                if (addressIdItem != address2Id.end()) {
-                    BtcId addressId = addressIdItem->second;
+                if (addressId != utils::btc::AddressIndex::NO_ID) {
                     addrItem.value() = addressId;
                 }
             }
@@ -218,12 +430,10 @@ inline void convertAddressesOfTx(
         auto& outputs = utils::json::get(tx, "out");
         for (auto& output : outputs) {
             auto addrItem = output.find("addr");
-            if (addrItem != output.cend()) {
-                std::string address = addrItem.value();
-                auto addressIdItem = address2Id.find(address);
+            if (addrItem != output.cend() && addrItem.value().is_string()) {
+                BtcId addressId = getAddressId(addrItem.value().get_ref<const std::string&>());
 
-                if (addressIdItem != address2Id.end()) {
-                    BtcId addressId = addressIdItem->second;
+                if (addressId != utils::btc::AddressIndex::NO_ID) {
                     addrItem.value() = addressId;
                 }
             }
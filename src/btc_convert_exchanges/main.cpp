@@ -11,6 +11,7 @@
 #include "utils/btc_utils.h"
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/address_index.h"
 #include "fmt/format.h"
 #include <nlohmann/json.hpp>
 
@@ -32,7 +33,7 @@ namespace fs = std::filesystem;
 std::vector<BtcId> convertAddress2Ids(
     const std::vector<std::string> addresses,
     std::vector<BtcId>& addressIds,
-    std::map<std::string, BtcId>& address2Id,
+    utils::btc::AddressIndex& address2Id,
     const std::string& appendFilePath
 );
 inline void logUsedMemory();
@@ -48,7 +49,7 @@ int main(int argc, char* argv[]) {
 
     const char* id2AddressFilePath = argv[1];
     logger.info("Load address2Id...");
-    auto address2Id = utils::btc::loadAddress2Id(id2AddressFilePath);
+    auto address2Id = utils::btc::AddressIndex::load(id2AddressFilePath);
     logger.info(fmt::format("Loaded address2Id: {} items", address2Id.size()));
 
     const char* exchangeAddressesFilePath = argv[2];
@@ -69,7 +70,7 @@ int main(int argc, char* argv[]) {
         const char* ufFilePath = argv[4];
         logger.info(fmt::format("Expand union find file from {}", ufFilePath));
 
-        utils::btc::WeightedQuickUnion uf(1);
+        utils::btc::RankedQuickUnion uf(1);
         uf.load(ufFilePath);
 
         auto originalSize = uf.getSize();
@@ -90,18 +91,14 @@ int main(int argc, char* argv[]) {
 std::vector<BtcId> convertAddress2Ids(
     const std::vector<std::string> addresses,
     std::vector<BtcId>& addressIds,
-    std::map<std::string, BtcId>& address2Id,
+    utils::btc::AddressIndex& address2Id,
     const std::string& appendFilePath
 ) {
-    std::ofstream addressIdFile(appendFilePath.c_str(), std::ios::app);
-
+    BtcId firstNewId = address2Id.size();
     BtcId maxId = address2Id.size();
     for (const auto& address : addresses) {
-        auto addressIt = address2Id.find(address);
-        if (addressIt == address2Id.end()) {
-            addressIdFile << address << std::endl;
-
-            address2Id[address] = maxId;
+        BtcId addressId = address2Id.insert(address);
+        if (addressId == maxId) {
             addressIds.push_back(maxId);
 
             logger.info(fmt::format("Append new address: {}/{}", address, maxId));
@@ -109,11 +106,14 @@ std::vector<BtcId> convertAddress2Ids(
             maxId = address2Id.size();
         }
         else {
-            addressIds.push_back(addressIt->second);
+            addressIds.push_back(addressId);
             logger.info(fmt::format("Found address: {}/{}", address, maxId));
         }
     }
 
+    // 新地址一次性追加，已有id不变
+    address2Id.appendToFile(appendFilePath, firstNewId);
+
     return addressIds;
 }
 
@@ -4,6 +4,7 @@
 #include "utils/io_utils.h"
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/id_bitset.h"
 #include "fmt/format.h"
 
 #include <cstdlib>
@@ -26,7 +27,7 @@ int main(int argc, char* argv[]) {
         const char* unionFindFilePath = argv[1];
         logger.info(fmt::format("Load union find form {}", unionFindFilePath));
 
-        utils::btc::WeightedQuickUnion quickUnion(1);
+        utils::btc::RankedQuickUnion quickUnion(1);
         quickUnion.load(unionFindFilePath);
 
         logger.info(fmt::format("Loaded ids: {}", quickUnion.getSize()));
@@ -36,22 +37,20 @@ int main(int argc, char* argv[]) {
         std::ofstream outputFile(outputFilePath);
         logger.info(fmt::format("Dump union find result to: {}", outputFilePath));
 
-        std::set<BtcId> exchangeRootAddresseIds;
+        utils::btc::IdBitset exchangeRootAddresseIds(quickUnion.getSize());
         if (argc == 4) {
             const char* exclusiveFilePath = argv[3];
-            std::vector<BtcId> addressIds = utils::readLines<std::vector<BtcId>, BtcId>(
-                exclusiveFilePath,
-                [](const std::string& line) -> BtcId {
-                    return std::stoi(line);
-                }
-            );
+            utils::btc::IdBitset addressIds = utils::btc::IdBitset::loadIdList(exclusiveFilePath);
 
-            for (BtcId addressId : addressIds) {
-                exchangeRootAddresseIds.insert(quickUnion.findRoot(addressId));
+            BtcSize addressIdCount = std::min(addressIds.getSize(), quickUnion.getSize());
+            for (BtcId addressId = 0; addressId != addressIdCount; ++addressId) {
+                if (addressIds.contains(addressId)) {
+                    exchangeRootAddresseIds.insert(quickUnion.findRoot(addressId));
+                }
             }
         }
         
-        const auto& quickUnionClusters = utils::btc::WeightedQuickUnionClusters(quickUnion);
+        const auto& quickUnionClusters = utils::btc::RankedQuickUnionClusters(quickUnion);
         BtcSize dumpedClusterCount = 0;
         BtcSize skippedClusterCount = 0;
         BtcSize skippedAddressCount = 0;
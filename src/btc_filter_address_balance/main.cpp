@@ -5,7 +5,9 @@
 
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/id_bitset.h"
 #include "utils/io_utils.h"
+#include "utils/line_loader.h"
 #include "utils/task_utils.h"
 #include "fmt/format.h"
 #include <argparse/argparse.hpp>
@@ -31,23 +33,23 @@ std::vector<std::string> getAddressBalancePaths(
     uint32_t startYear,
     uint32_t endYear
 );
-std::set<BtcId> loadExcludeRootAddresses(
+utils::btc::IdBitset loadExcludeRootAddresses(
     const std::string& excludeAddressListFilePath,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 );
 
 void processAddressBalanceOfYears(
     uint32_t workerIndex,
     const std::vector<std::string>* addressBalanceFilePaths,
     const std::string& outputBaseDir,
-    utils::btc::WeightedQuickUnion* quickUnion,
-    const std::set<BtcId>* excludeAddresses
+    utils::btc::RankedQuickUnion* quickUnion,
+    const utils::btc::IdBitset* excludeAddresses
 );
 void processYearAddressBalance(
     const std::string& addressBalanceFilePath,
     const std::string& entityBalanceFilePath,
-    utils::btc::WeightedQuickUnion& quickUnion,
-    const std::set<BtcId>& excludeAddresses
+    utils::btc::RankedQuickUnion& quickUnion,
+    const utils::btc::IdBitset& excludeAddresses
 );
 void checkYearAddressBalance(
     const std::string& addressBalanceFilePath
@@ -92,13 +94,13 @@ int main(int argc, char* argv[]) {
         const std::vector<std::vector<std::string>> taskChunks = utils::generateTaskChunks(addressBalanceFiles, workerCount);
 
         const std::string ufFilePath = argumentParser.get("--union_file");
-        utils::btc::WeightedQuickUnion quickUnion(1);
+        utils::btc::RankedQuickUnion quickUnion(1);
         logger.info(fmt::format("Load quickUnion from {}", ufFilePath));
         quickUnion.load(ufFilePath);
         logger.info(fmt::format("Loaded quickUnion {} items from {}", quickUnion.getSize(), ufFilePath));
 
         const std::string excludeAddressListFilePath = argumentParser.get("--exclude_addrs");
-        const std::set<BtcId>& excludeRootAddresses = loadExcludeRootAddresses(excludeAddressListFilePath, quickUnion);
+        const utils::btc::IdBitset& excludeRootAddresses = loadExcludeRootAddresses(excludeAddressListFilePath, quickUnion);
 
         std::string outputBaseDirPath = argumentParser.get("output_base_dir");
 
@@ -204,19 +206,15 @@ std::vector<std::string> getAddressBalancePaths(
     return addressBalanceFilePaths;
 }
 
-std::set<BtcId> loadExcludeRootAddresses(
+utils::btc::IdBitset loadExcludeRootAddresses(
     const std::string& excludeAddressListFilePath,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 ) {
-    std::set<BtcId> excludeRootAddresses;
+    utils::btc::IdBitset excludeRootAddresses(quickUnion.getSize());
 
     if (!excludeAddressListFilePath.empty()) {
         logger.info(fmt::format("Load excludeAddresses: {}", excludeAddressListFilePath));
-        std::vector<BtcId> excludeAddresses = utils::readLines<std::vector<BtcId>, BtcId>(
-            excludeAddressListFilePath,
-            [](const std::string& line) -> BtcId {
-                return std::stoi(line);
-        });
+        std::vector<BtcId> excludeAddresses = utils::loadNumberLines<BtcId>(excludeAddressListFilePath);
         logger.info(fmt::format("Loaded excludeAddresses: {}", excludeAddresses.size()));
 
         for (BtcId addressId : excludeAddresses) {
@@ -231,8 +229,8 @@ void processAddressBalanceOfYears(
     uint32_t workerIndex,
     const std::vector<std::string>* addressBalanceFilePaths,
     const std::string& outputBaseDir,
-    utils::btc::WeightedQuickUnion* quickUnion,
-    const std::set<BtcId>* excludeAddresses
+    utils::btc::RankedQuickUnion* quickUnion,
+    const utils::btc::IdBitset* excludeAddresses
 ) {
     fs::path outputBaseDirPath(outputBaseDir);
 
@@ -274,8 +272,8 @@ void checkYearAddressBalance(
 void processYearAddressBalance(
     const std::string& addressBalanceFilePath,
     const std::string& entityBalanceFilePath,
-    utils::btc::WeightedQuickUnion& quickUnion,
-    const std::set<BtcId>& exchangeRootAddresseIds
+    utils::btc::RankedQuickUnion& quickUnion,
+    const utils::btc::IdBitset& exchangeRootAddresseIds
 ) {
     using utils::btc::BtcSize;
 
@@ -297,7 +295,7 @@ void processYearAddressBalance(
         ++currentAddressId;
     }
 
-    const auto& quickUnionClusters = utils::btc::WeightedQuickUnionClusters(quickUnion);
+    const auto& quickUnionClusters = utils::btc::RankedQuickUnionClusters(quickUnion);
     BtcSize dumpedClusterCount = 0;
     BtcSize skippedClusterCount = 0;
     BtcSize skippedAddressCount = 0;
@@ -8,16 +8,21 @@
 #include "utils/json_utils.h"
 #include "utils/mem_utils.h"
 #include "utils/btc_utils.h"
+#include "utils/address_codec.h"
+#include "utils/address_index.h"
+#include "utils/sorted_merge.h"
 #include "fmt/format.h"
 #include <argparse/argparse.hpp>
 
 #include <cstdlib>
+#include <exception>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
 #include <future>
 #include <set>
+#include <unordered_set>
 #include <filesystem>
 #include <thread>
 #include <nlohmann/json.hpp>
@@ -32,34 +37,30 @@ static argparse::ArgumentParser createArgumentParser();
 void getUniqueAddressesOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    std::set<std::string>* inputAdresses,
-    std::set<std::string>* outputAdresses
+    utils::PackedLines* sortedAddresses
 );
 
-void getUniqueAddressesOfDay(
-    const std::string& dayDir,
-    std::set<std::string>& inputAdresses,
-    std::set<std::string>& outputAdresses
+void spillUniqueAddressesOfDays(
+    uint32_t workerIndex,
+    const std::vector<std::string>* daysDirList,
+    const std::string& spillDirPath,
+    size_t memoryBudget,
+    std::vector<std::string>* runFilePaths
 );
 
-inline void getUniqueAddressesOfBlock(
+void getFirstSeenAddressesOfDay(
     const std::string& dayDir,
-    const json& block,
-    std::set<std::string>& inputAdresses,
-    std::set<std::string>& outputAdresses
+    std::vector<std::string>* addresses
 );
 
-inline void getUniqueAddressesOfTx(
-    const std::string& dayDir,
-    const json& tx,
-    std::set<std::string>& inputAdresses,
-    std::set<std::string>& outputAdresses
-);
+template <class AddressFunc>
+void forEachAddressOfDay(const std::string& dayDir, AddressFunc handler);
+
+template <class AddressFunc>
+inline void forEachAddressOfBlock(const std::string& dayDir, const json& block, AddressFunc& handler);
 
-inline std::set<std::string> mergeUniqueAddresses(
-    const std::string& label,
-    std::vector<std::set<std::string>>& tasksUniqueAddresses
-);
+template <class AddressFunc>
+inline void forEachAddressOfTx(const std::string& dayDir, const json& tx, AddressFunc& handler);
 
 inline void logUsedMemory();
 
@@ -92,39 +93,162 @@ int main(int argc, char* argv[]) {
     logger.info(fmt::format("Worker count: {}", workerCount));
 
     const std::vector<std::vector<std::string>> taskChunks = utils::generateTaskChunks(daysList, workerCount);
-    std::vector<std::set<std::string>> tasksInputUniqueAddresses(workerCount);
-    std::vector<std::set<std::string>> tasksOutputUniqueAddresses(workerCount);
+
+    std::string order = argumentParser.get("--order");
+    bool appendAddresses = argumentParser.get<bool>("--append");
+    if (appendAddresses && order != "first_seen") {
+        logger.error("--append needs --order first_seen, lexical ids change with every new address");
+
+        return EXIT_FAILURE;
+    }
+
+    std::string spillDirPath = argumentParser.get("--spill_dir");
+    if (!spillDirPath.empty() && order != "lexical") {
+        logger.error("--spill_dir needs --order lexical, first_seen ids can't be merged from sorted runs");
+
+        return EXIT_FAILURE;
+    }
+
+    if (order == "first_seen") {
+        logger.info("Assign ids by first appearance");
+
+        // 已有地址保持原id，只把新地址追加到id2addr末尾
+        utils::btc::AddressIndex address2Id;
+        if (appendAddresses && fs::exists(id2AddressFilePath)) {
+            logger.info(fmt::format("Load address2Id from {}", id2AddressFilePath));
+            address2Id = utils::btc::AddressIndex::load(id2AddressFilePath);
+            logger.info(fmt::format("Loaded address2Id: {} items", address2Id.size()));
+        }
+        BtcId firstNewId = address2Id.size();
+
+        // days_dir_list is in time order, so the first day of an address decides its id. Days are read
+        // workerCount at a time and inserted in list order, only one window of days is held besides the index.
+        size_t totalAddressCount = 0;
+        for (size_t windowBegin = 0; windowBegin < daysList.size(); windowBegin += workerCount) {
+            size_t windowEnd = std::min<size_t>(windowBegin + workerCount, daysList.size());
+
+            std::vector<std::vector<std::string>> windowAddresses(windowEnd - windowBegin);
+            std::vector<std::future<void>> tasks;
+            for (size_t dayIndex = windowBegin; dayIndex != windowEnd; ++dayIndex) {
+                tasks.push_back(
+                    std::async(
+                        std::launch::async,
+                        getFirstSeenAddressesOfDay,
+                        std::cref(daysList[dayIndex]),
+                        &windowAddresses[dayIndex - windowBegin]
+                    )
+                );
+            }
+            for (auto& task : tasks) {
+                task.get();
+            }
+
+            for (const auto& dayAddresses : windowAddresses) {
+                totalAddressCount += dayAddresses.size();
+                for (const auto& address : dayAddresses) {
+                    address2Id.insert(address);
+                }
+            }
+            logUsedMemory();
+        }
+        logger.info(fmt::format("Final unique addresses first_seen: {}/{}", address2Id.size(), totalAddressCount));
+
+        // Without --append the file is written from scratch
+        if (!appendAddresses) {
+            fs::remove(id2AddressFilePath);
+        }
+
+        logger.info(fmt::format("Append {} addresses to {}", address2Id.size() - firstNewId, id2AddressFilePath));
+        address2Id.appendToFile(id2AddressFilePath, firstNewId);
+        logUsedMemory();
+
+        return EXIT_SUCCESS;
+    }
+    else if (order != "lexical") {
+        logger.error(fmt::format("Unknown id order: {}", order));
+
+        return EXIT_FAILURE;
+    }
+
+    if (!spillDirPath.empty()) {
+        // 内存超出预算时将排序去重后的地址写入临时文件，最后流式归并
+        size_t workerMemoryBudget = argumentParser.get<uint64_t>("--memory_budget") * 1024 * 1024 / workerCount;
+        logger.info(fmt::format("Spill addresses to {}, worker memory budget: {}MB", spillDirPath, workerMemoryBudget / 1024 / 1024));
+        fs::create_directories(spillDirPath);
+
+        std::vector<std::vector<std::string>> tasksRunFilePaths(workerCount);
+        std::vector<std::future<void>> tasks;
+        for (uint32_t workerIndex = 0; workerIndex != taskChunks.size(); ++workerIndex) {
+            tasks.push_back(
+                std::async(
+                    spillUniqueAddressesOfDays,
+                    workerIndex,
+                    &taskChunks[workerIndex],
+                    spillDirPath,
+                    workerMemoryBudget,
+                    &tasksRunFilePaths[workerIndex]
+                )
+            );
+        }
+        utils::waitForTasks(logger, tasks);
+
+        try {
+            // A lost run would drop addresses silently, so spill errors stop here
+            for (auto& task : tasks) {
+                task.get();
+            }
+
+            std::vector<std::string> runFilePaths;
+            for (const auto& taskRunFilePaths : tasksRunFilePaths) {
+                runFilePaths.insert(runFilePaths.end(), taskRunFilePaths.cbegin(), taskRunFilePaths.cend());
+            }
+
+            logger.info(fmt::format("Merge {} address runs to {}", runFilePaths.size(), id2AddressFilePath));
+            auto addressCount = utils::mergeSortedUniqueFiles(id2AddressFilePath, runFilePaths);
+            logger.info(fmt::format("Final unique addresses: {}", addressCount));
+
+            for (const auto& runFilePath : runFilePaths) {
+                fs::remove(runFilePath);
+            }
+        }
+        catch (const std::exception& e) {
+            logger.error(e.what());
+
+            return EXIT_FAILURE;
+        }
+        logUsedMemory();
+
+        return EXIT_SUCCESS;
+    }
+
+    // 每个worker以二进制key去重并排序，最后并行归并写出
+    std::vector<utils::PackedLines> tasksSortedAddresses(workerCount);
 
     uint32_t workerIndex = 0;
     std::vector<std::future<void>> tasks;
     for (const auto& taskChunk : taskChunks) {
-        auto& taskInputUniqueAddresses = tasksInputUniqueAddresses[workerIndex];
-        auto& taskOutputUniqueAddresses = tasksOutputUniqueAddresses[workerIndex];
         tasks.push_back(
             std::async(
                 getUniqueAddressesOfDays,
                 workerIndex,
                 &taskChunk,
-                &taskInputUniqueAddresses,
-                &taskOutputUniqueAddresses
+                &tasksSortedAddresses[workerIndex]
             )
         );
 
         ++ workerIndex;
     }
     utils::waitForTasks(logger, tasks);
-
-    std::vector<std::set<std::string>> allUniqueAddresses;
-    allUniqueAddresses.push_back(mergeUniqueAddresses("input", tasksInputUniqueAddresses));
-    logUsedMemory();
-    allUniqueAddresses.push_back(mergeUniqueAddresses("output", tasksOutputUniqueAddresses));
     logUsedMemory();
 
-    const auto& id2Address = mergeUniqueAddresses("final", allUniqueAddresses);
-    logUsedMemory();
+    size_t totalAddressCount = 0;
+    for (const auto& taskSortedAddresses : tasksSortedAddresses) {
+        totalAddressCount += taskSortedAddresses.size();
+    }
 
-    logger.info(fmt::format("Dump address to {}", id2AddressFilePath));
-    utils::btc::dumpId2Address(id2AddressFilePath.c_str(), id2Address);
+    logger.info(fmt::format("Merge address to {}", id2AddressFilePath));
+    auto addressCount = utils::writeSortedUniqueLines(id2AddressFilePath, tasksSortedAddresses, workerCount);
+    logger.info(fmt::format("Final unique addresses: {}/{}", addressCount, totalAddressCount));
     logUsedMemory();
 
     return EXIT_SUCCESS;
@@ -146,29 +270,113 @@ static argparse::ArgumentParser createArgumentParser() {
         .scan<'d', uint32_t>()
         .required();
 
+    program.add_argument("--order")
+        .help("Id order: lexical (sorted addresses) or first_seen (by day, block and tx of first appearance). "
+            "first_seen files aren't sorted, combine them with btc_combine_address --first_seen")
+        .default_value(std::string("lexical"));
+
+    program.add_argument("--append")
+        .help("first_seen order only. Keep the ids of an existing id2addr and append the new addresses to it, "
+            "so that days can be added without renumbering")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--spill_dir")
+        .help("Directory for sorted address runs, lexical order only. Workers write a run when they reach the memory budget and the runs are merged at the end")
+        .default_value(std::string(""));
+
+    program.add_argument("--memory_budget")
+        .help("Memory budget in MB shared by the workers when spilling")
+        .scan<'d', uint64_t>()
+        .default_value(uint64_t(4096));
+
     return program;
 }
 
 void getUniqueAddressesOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysList,
-    std::set<std::string>* inputAdresses,
-    std::set<std::string>* outputAdresses
+    utils::PackedLines* sortedAddresses
 ) {
     logger.info(fmt::format("Worker started: {}", workerIndex));
 
+    utils::btc::AddressSet uniqueAddresses;
     for (const auto& dayDir : *daysList) {
-        getUniqueAddressesOfDay(dayDir, *inputAdresses, *outputAdresses);
+        forEachAddressOfDay(dayDir, [&uniqueAddresses](const std::string& address, bool) {
+            uniqueAddresses.insert(address);
+        });
         auto usedMemory = utils::mem::getAllocatedMemory();
         logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
     }
+
+    logger.info(fmt::format("Sort task unique addresses {}: {}", workerIndex, uniqueAddresses.size()));
+    *sortedAddresses = uniqueAddresses.extractPackedSortedAddresses();
 }
 
-void getUniqueAddressesOfDay(
+void spillUniqueAddressesOfDays(
+    uint32_t workerIndex,
+    const std::vector<std::string>* daysList,
+    const std::string& spillDirPath,
+    size_t memoryBudget,
+    std::vector<std::string>* runFilePaths
+) {
+    logger.info(fmt::format("Worker started: {}", workerIndex));
+
+    utils::btc::AddressSet uniqueAddresses;
+    auto spillRun = [&]() {
+        auto runFilePath = (fs::path(spillDirPath) / fmt::format("addresses.{}.{}", workerIndex, runFilePaths->size())).string();
+        logger.info(fmt::format("Spill {} addresses to {}", uniqueAddresses.size(), runFilePath));
+
+        utils::dumpSortedRun(runFilePath, uniqueAddresses.extractPackedSortedAddresses());
+        runFilePaths->push_back(runFilePath);
+    };
+
+    for (const auto& dayDir : *daysList) {
+        // Checked after every insert, so a large day can't overshoot the budget. Encoding a full set
+        // needs about as much again for the packed strings. forEachAddressOfDay only logs errors,
+        // a failed spill is kept and thrown after the day, since its addresses are gone.
+        std::exception_ptr spillError;
+        forEachAddressOfDay(dayDir, [&](const std::string& address, bool) {
+            if (spillError) {
+                return;
+            }
+
+            uniqueAddresses.insert(address);
+            if (uniqueAddresses.getMemoryUsage() > memoryBudget / 2) {
+                try {
+                    spillRun();
+                }
+                catch (...) {
+                    spillError = std::current_exception();
+                }
+            }
+        });
+
+        if (spillError) {
+            std::rethrow_exception(spillError);
+        }
+    }
+
+    if (uniqueAddresses.size()) {
+        spillRun();
+    }
+}
+
+void getFirstSeenAddressesOfDay(
     const std::string& dayDir,
-    std::set<std::string>& inputAdresses,
-    std::set<std::string>& outputAdresses
+    std::vector<std::string>* addresses
 ) {
+    // 按区块和交易顺序记录当天首次出现的地址
+    std::unordered_set<std::string> seenAddresses;
+    forEachAddressOfDay(dayDir, [&](const std::string& address, bool) {
+        if (seenAddresses.insert(address).second) {
+            addresses->push_back(address);
+        }
+    });
+}
+
+template <class AddressFunc>
+void forEachAddressOfDay(const std::string& dayDir, AddressFunc handler) {
     try {
         auto combinedBlocksFilePath = fmt::format("{}/{}", dayDir, "combined-block-list.json");
         logger.info(fmt::format("Process combined blocks file: {}", dayDir));
@@ -184,7 +392,7 @@ void getUniqueAddressesOfDay(
         logger.info(fmt::format("Block count: {} {}", dayDir, blocks.size()));
 
         for (const auto& block : blocks) {
-            getUniqueAddressesOfBlock(dayDir, block, inputAdresses, outputAdresses);
+            forEachAddressOfBlock(dayDir, block, handler);
         }
 
         logger.info(fmt::format("Finished process blocks by date: {}", dayDir));
@@ -195,19 +403,15 @@ void getUniqueAddressesOfDay(
     }
 }
 
-inline void getUniqueAddressesOfBlock(
-    const std::string& dayDir,
-    const json& block,
-    std::set<std::string>& inputAdresses,
-    std::set<std::string>& outputAdresses
-) {
+template <class AddressFunc>
+inline void forEachAddressOfBlock(const std::string& dayDir, const json& block, AddressFunc& handler) {
     std::string blockHash = utils::json::get(block, "hash");
 
     try {
         const auto& txs = block["tx"];
 
         for (const auto& tx : txs) {
-            getUniqueAddressesOfTx(dayDir, tx, inputAdresses, outputAdresses);
+            forEachAddressOfTx(dayDir, tx, handler);
         }
     }
     catch (std::exception& e) {
@@ -216,12 +420,8 @@ inline void getUniqueAddressesOfBlock(
     }
 }
 
-inline void getUniqueAddressesOfTx(
-    const std::string& dayDir,
-    const json& tx,
-    std::set<std::string>& inputAdresses,
-    std::set<std::string>& outputAdresses
-) {
+template <class AddressFunc>
+inline void forEachAddressOfTx(const std::string& dayDir, const json& tx, AddressFunc& handler) {
     std::string txHash = utils::json::get(tx, "hash");
 
     try {
@@ -235,7 +435,7 @@ inline void getUniqueAddressesOfTx(
 
             const auto addrItem = prevOut.find("addr");
             if (addrItem != prevOut.cend()) {
-                inputAdresses.insert(addrItem.value());
+                handler(addrItem.value().get_ref<const std::string&>(), true);
             }
         }
 
@@ -243,7 +443,7 @@ inline void getUniqueAddressesOfTx(
         for (const auto& output : outputs) {
             const auto addrItem = output.find("addr");
             if (addrItem != output.cend()) {
-                outputAdresses.insert(addrItem.value());
+                handler(addrItem.value().get_ref<const std::string&>(), false);
             }
         }
     }
@@ -253,27 +453,6 @@ inline void getUniqueAddressesOfTx(
     }
 }
 
-inline std::set<std::string> mergeUniqueAddresses(
-    const std::string& label,
-    std::vector<std::set<std::string>>& tasksUniqueAddresses
-) {
-    std::set<std::string> finalAddressSet;
-    size_t totalAddressCount = 0;
-    while (tasksUniqueAddresses.size()) {
-        const auto& taskUniqueAddresses = tasksUniqueAddresses.back();
-        logger.info(fmt::format("Generated task unique addresses: {}", taskUniqueAddresses.size()));
-        totalAddressCount += taskUniqueAddresses.size();
-
-        finalAddressSet.insert(taskUniqueAddresses.cbegin(), taskUniqueAddresses.cend());
-        tasksUniqueAddresses.pop_back();
-    }
-
-    logger.info(fmt::format("Final unique addresses {}: {}/{}", label, finalAddressSet.size(), totalAddressCount));
-    logger.info(fmt::format("Remove duplicated addresses {}: {}", label, totalAddressCount - finalAddressSet.size()));
-
-    return finalAddressSet;
-}
-
 inline void logUsedMemory() {
     auto usedMemory = utils::mem::getAllocatedMemory();
     logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
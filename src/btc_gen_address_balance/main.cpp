@@ -4,6 +4,7 @@
 #include "logging/Logger.h"
 #include "logging/handlers/FileHandler.h"
 #include "utils/io_utils.h"
+#include "utils/line_loader.h"
 #include "utils/task_utils.h"
 #include "utils/json_utils.h"
 #include "utils/btc_utils.h"
@@ -366,29 +367,15 @@ std::size_t loadBalanceList(
     BalanceList& balanceList
 ) {
     logger.info(fmt::format("Load balance from: {}", inputFilePath));
-    std::ifstream inputFile(inputFilePath.c_str());
-    std::size_t loadedCount = 0;
 
-    while (inputFile) {
-        std::string line;
-        std::getline(inputFile, line);
-
-        auto seperatorPos = line.find(',');
-        if (seperatorPos == std::string::npos) {
-            continue;
+    // 每个id只出现一次，各分块可以并行写入
+    return utils::forEachIdValueLine<BtcId, BalanceValue>(inputFilePath, [&](BtcId btcId, BalanceValue btcValue) {
+        if (btcId >= balanceList.size()) {
+            throw std::runtime_error(fmt::format("Address id {} of {} is out of range", btcId, inputFilePath));
         }
 
-        std::string btcIdString = line.substr(0, seperatorPos);
-        std::string balanceString = line.substr(seperatorPos + 1);
-
-        BtcId btcId = std::stoll(btcIdString);
-        BalanceValue btcValue = std::stod(balanceString);
-
         balanceList[btcId] = btcValue;
-        ++ loadedCount;
-    }
-
-    return loadedCount;
+    });
 }
 
 void dumpBalanceList(
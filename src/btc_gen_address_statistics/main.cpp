@@ -50,7 +50,7 @@ static argparse::ArgumentParser createArgumentParser();
 void generateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const utils::btc::WeightedQuickUnion* quickUnion,
+    const utils::btc::RankedQuickUnion* quickUnion,
     CountList* addressCountList,
     CountList* entityCountList,
     CountList* activateEntityCountList
@@ -58,7 +58,7 @@ void generateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfDays(
     const std::string& dayDir,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -66,7 +66,7 @@ void calculateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfBlock(
     const json& block,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -74,7 +74,7 @@ void calculateAddressStatisticsOfBlock(
 
 void calculateAddressStatisticsOfTx(
     const json& tx,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -82,7 +82,7 @@ void calculateAddressStatisticsOfTx(
 
 void processAddress(
     BtcId addressId,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -159,7 +159,7 @@ int main(int argc, char* argv[]) {
     logger.info(fmt::format("Using end year: {}", endYear));
 
     const std::string ufFilePath = argumentParser.get("--union_file");
-    utils::btc::WeightedQuickUnion quickUnion(1);
+    utils::btc::RankedQuickUnion quickUnion(1);
     logger.info(fmt::format("Load quickUnion from {}", ufFilePath));
     quickUnion.load(ufFilePath);
     logger.info(fmt::format("Loaded quickUnion {} items from {}", quickUnion.getSize(), ufFilePath));
@@ -360,7 +360,7 @@ groupDaysListByYears(const std::vector<std::string>& daysList, uint32_t startYea
 void generateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const utils::btc::WeightedQuickUnion* quickUnion,
+    const utils::btc::RankedQuickUnion* quickUnion,
     CountList* addressCountList,
     CountList* entityCountList,
     CountList* activateEntityCountList
@@ -381,7 +381,7 @@ void generateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfDays(
     const std::string& dayDir,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -426,7 +426,7 @@ void calculateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfBlock(
     const json& block,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -450,7 +450,7 @@ void calculateAddressStatisticsOfBlock(
 
 void calculateAddressStatisticsOfTx(
     const json& tx,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -498,7 +498,7 @@ void calculateAddressStatisticsOfTx(
 
 void processAddress(
     BtcId addressId,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
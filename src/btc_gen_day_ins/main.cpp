@@ -7,6 +7,8 @@
 #include "utils/json_utils.h"
 #include "utils/btc_utils.h"
 #include "utils/mem_utils.h"
+#include "utils/day_inputs.h"
+#include "utils/id_bitset.h"
 #include "fmt/format.h"
 #include <nlohmann/json.hpp>
 #include <argparse/argparse.hpp>
@@ -31,37 +33,40 @@ static argparse::ArgumentParser createArgumentParser();
 void generateTxInputsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const std::set<BtcId>* excludeAddresses,
+    const utils::btc::IdBitset* excludeAddresses,
     bool skipExisted,
     bool excludeInputs,
-    std::string dayInputsFileName
+    std::string dayInputsFileName,
+    utils::btc::DayInputsEncoding encoding
 );
 
 void generateTxInputsOfDay(
     const std::string& dayDir,
-    const std::set<BtcId>& excludeAddresses,
+    const utils::btc::IdBitset& excludeAddresses,
     bool skipExisted,
     bool excludeInputs,
-    std::string dayInputsFileName
+    std::string dayInputsFileName,
+    utils::btc::DayInputsEncoding encoding
 );
 
 inline std::vector<std::vector<BtcId>> generateTxInputsOfBlock(
     const std::string& dayDir,
-    const std::set<BtcId>& excludeAddresses,
+    const utils::btc::IdBitset& excludeAddresses,
     bool excludeInputs,
     const json& block
 );
 
 inline std::vector<BtcId> generateTxInputs(
     const std::string& dayDir,
-    const std::set<BtcId>& excludeAddresses,
+    const utils::btc::IdBitset& excludeAddresses,
     bool excludeInputs,
     const json& tx
 );
 
 inline void dumpDayInputs(
     const char* filePath,
-    const std::vector<std::vector<std::vector<BtcId>>>& txInputsOfDay
+    const std::vector<std::vector<std::vector<BtcId>>>& txInputsOfDay,
+    utils::btc::DayInputsEncoding encoding
 );
 
 inline void logUsedMemory();
@@ -94,20 +99,12 @@ int main(int argc, char* argv[]) {
 
     logUsedMemory();
 
-    std::set<BtcId> excludeAddresses;
+    utils::btc::IdBitset excludeAddresses;
     const std::string excludeAddressListFilePath = argumentParser.get("--exclude_addrs");
     if (!excludeAddressListFilePath.empty()) {
         logger.info(fmt::format("Load excludeAddresses: {}", excludeAddressListFilePath));
-        excludeAddresses = utils::readLines<std::set<BtcId>, BtcId>(
-            excludeAddressListFilePath,
-            [](const std::string& line) -> BtcId {
-                return std::stoi(line);
-            },
-            [](std::set<BtcId>& container, BtcId addressId) {
-                container.insert(addressId);
-            }
-        );
-        logger.info(fmt::format("Loaded excludeAddresses: {}", excludeAddresses.size()));
+        excludeAddresses = utils::btc::IdBitset::loadIdList(excludeAddressListFilePath);
+        logger.info(fmt::format("Loaded excludeAddresses: {}", excludeAddresses.count()));
         logUsedMemory();
     }
 
@@ -125,6 +122,13 @@ int main(int argc, char* argv[]) {
     }
 
     std::string dayInputsFileName = argumentParser.get("--day_ins_file");
+    auto encoding = argumentParser.get<bool>("--delta_varint") ?
+        utils::btc::DayInputsEncoding::DeltaVarint :
+        utils::btc::DayInputsEncoding::Raw;
+    if (utils::btc::isBinaryDayInputsPath(dayInputsFileName)) {
+        logger.info(fmt::format("Write binary day inputs, delta varint: {}", encoding == utils::btc::DayInputsEncoding::DeltaVarint));
+    }
+
     uint32_t workerIndex = 0;
     std::vector<std::future<void>> tasks;
     for (const auto& taskChunk : taskChunks) {
@@ -136,7 +140,8 @@ int main(int argc, char* argv[]) {
                 &excludeAddresses,
                 skipExisted,
                 excludeInputs,
-                dayInputsFileName
+                dayInputsFileName,
+                encoding
             )
         );
 
@@ -155,9 +160,14 @@ static argparse::ArgumentParser createArgumentParser() {
         .help("List file path of days directories");
 
     program.add_argument("-d", "--day_ins_file")
-        .help("Filename of day inputs address file")
+        .help("Filename of day inputs address file, a .bin file name writes the binary format")
         .default_value("day-inputs.json");
 
+    program.add_argument("--delta_varint")
+        .help("Store ids of binary day inputs as varint gaps")
+        .implicit_value(true)
+        .default_value(false);
+
     program.add_argument("-e", "--exclude_addrs")
         .help("Exclude addresses file path")
         .default_value("");
@@ -183,24 +193,26 @@ static argparse::ArgumentParser createArgumentParser() {
 void generateTxInputsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysList,
-    const std::set<BtcId>* excludeAddresses,
+    const utils::btc::IdBitset* excludeAddresses,
     bool skipExisted,
     bool excludeInputs,
-    std::string dayInputsFileName
+    std::string dayInputsFileName,
+    utils::btc::DayInputsEncoding encoding
 ) {
     logger.info(fmt::format("Worker started: {}", workerIndex));
 
     for (const auto& dayDir : *daysList) {
-        generateTxInputsOfDay(dayDir, *excludeAddresses, skipExisted, excludeInputs, dayInputsFileName);
+        generateTxInputsOfDay(dayDir, *excludeAddresses, skipExisted, excludeInputs, dayInputsFileName, encoding);
     }
 }
 
 void generateTxInputsOfDay(
     const std::string& dayDir,
-    const std::set<BtcId>& excludeAddresses,
+    const utils::btc::IdBitset& excludeAddresses,
     bool skipExisted,
     bool excludeInputs,
-    std::string dayInputsFileName
+    std::string dayInputsFileName,
+    utils::btc::DayInputsEncoding encoding
 ) {
     try {
         auto txInputsOfDayFilePath = fmt::format("{}/{}", dayDir, dayInputsFileName);
@@ -236,7 +248,7 @@ void generateTxInputsOfDay(
         logger.info(fmt::format("Dump tx inputs of {} blocks by date: {}", txInputsOfDay.size(), dayDir));
 
         logUsedMemory();
-        dumpDayInputs(txInputsOfDayFilePath.c_str(), txInputsOfDay);
+        dumpDayInputs(txInputsOfDayFilePath.c_str(), txInputsOfDay, encoding);
 
         logger.info(fmt::format("Finished process blocks by date: {}", dayDir));
 
@@ -250,7 +262,7 @@ void generateTxInputsOfDay(
 
 inline std::vector<std::vector<BtcId>> generateTxInputsOfBlock(
     const std::string& dayDir,
-    const std::set<BtcId>& excludeAddresses,
+    const utils::btc::IdBitset& excludeAddresses,
     bool excludeInputs,
     const json& block
 ) {
@@ -278,7 +290,7 @@ inline std::vector<std::vector<BtcId>> generateTxInputsOfBlock(
 
 inline std::vector<BtcId> generateTxInputs(
     const std::string& dayDir,
-    const std::set<BtcId>& excludeAddresses,
+    const utils::btc::IdBitset& excludeAddresses,
     bool excludeInputs,
     const json& tx
 ) {
@@ -337,10 +349,17 @@ inline std::vector<BtcId> generateTxInputs(
 
 void dumpDayInputs(
     const char* filePath,
-    const std::vector<std::vector<std::vector<BtcId>>>& txInputsOfDay
+    const std::vector<std::vector<std::vector<BtcId>>>& txInputsOfDay,
+    utils::btc::DayInputsEncoding encoding
 ) {
     logger.info(fmt::format("Dump day_ins: {}", filePath));
 
+    if (utils::btc::isBinaryDayInputsPath(filePath)) {
+        utils::btc::dumpBinaryDayInputs(filePath, txInputsOfDay, encoding);
+
+        return;
+    }
+
     json txInputsOfDayJson(txInputsOfDay);
     std::ofstream txInputsOfDayFile(filePath);
     txInputsOfDayFile << txInputsOfDayJson;
@@ -0,0 +1,16 @@
+#include "btc_gen_entity_index/logger.h"
+
+LoggerType& getLogger() {
+    using logging::LoggerFactory;
+    using logging::Level;
+    using logging::handlers::StreamHandler;
+    using logging::handlers::FileHandler;
+    using logging::formatters::cstr::formatRecord;
+
+    static auto logger = LoggerFactory<Level::Debug>::createLogger("Gen Entity Index", std::make_tuple(
+        StreamHandler<Level::Debug>(formatRecord),
+        FileHandler<Level::Debug>::create("logs/btc_gen_entity_index.log", formatRecord)
+    ));
+
+    return logger;
+}
@@ -0,0 +1,90 @@
+// 生成实体到地址的索引
+
+#include "btc-config.h"
+#include "btc_gen_entity_index/logger.h"
+
+#include "utils/mem_utils.h"
+#include "utils/union_find.h"
+#include "utils/entity_index.h"
+#include "fmt/format.h"
+#include <argparse/argparse.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+static argparse::ArgumentParser createArgumentParser();
+
+inline void logUsedMemory();
+
+auto& logger = getLogger();
+
+int main(int argc, char* argv[]) {
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
+    }
+
+    try {
+        uint32_t workerCount = std::min(
+            argumentParser.get<uint32_t>("--worker_count"),
+            std::thread::hardware_concurrency()
+        );
+        logger.info(fmt::format("Worker count: {}", workerCount));
+
+        std::string unionFindFilePath = argumentParser.get("uf_file");
+        utils::btc::UnionFindView quickUnion(unionFindFilePath);
+        logger.info(fmt::format(
+            "Mapped ids: {}, entities: {}, frozen roots: {}",
+            quickUnion.getSize(), quickUnion.getClusterCount(), quickUnion.hasFrozenRoots()
+        ));
+
+        std::string entityIndexFilePath = argumentParser.get("--output");
+        if (entityIndexFilePath.empty()) {
+            entityIndexFilePath = utils::btc::getEntityIndexPath(unionFindFilePath).string();
+        }
+
+        logger.info(fmt::format("Build entity index to {}", entityIndexFilePath));
+        utils::btc::buildEntityIndex(quickUnion, entityIndexFilePath, workerCount);
+        logger.info("Finished building entity index");
+
+        logUsedMemory();
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        logger.error(e.what());
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_gen_entity_index");
+
+    program.add_argument("uf_file")
+        .required()
+        .help("The union find file path");
+
+    program.add_argument("--output")
+        .help("The entity index file path, <uf_file>.idx by default")
+        .default_value("");
+
+    program.add_argument("-w", "--worker_count")
+        .help("Max worker count")
+        .scan<'d', uint32_t>()
+        .required();
+
+    return program;
+}
+
+inline void logUsedMemory() {
+    auto usedMemory = utils::mem::getAllocatedMemory();
+    logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
+}
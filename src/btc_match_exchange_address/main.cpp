@@ -6,10 +6,14 @@
 #include "utils/task_utils.h"
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/address_index.h"
+#include "utils/id2address.h"
+#include "utils/address_bloom_filter.h"
 #include "fmt/format.h"
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
 
 using utils::btc::BtcSize;
 
@@ -29,13 +33,29 @@ struct ExchangeWalletMatchResult {
     BtcSize clusterSize;
 };
 
+// Text id2addr is loaded into an AddressIndex, binary id2addr with a hash index is used in place.
+// Addresses the bloom filter rejects are not looked up at all.
+struct AddressFinder {
+    const utils::btc::AddressIndex* addressIndex;
+    const utils::btc::Id2AddressView* id2Address;
+    const utils::btc::AddressBloomFilter* bloomFilter;
+
+    BtcId find(std::string_view address) const {
+        if (bloomFilter && !bloomFilter->mayContain(address)) {
+            return utils::btc::AddressIndex::NO_ID;
+        }
+
+        return id2Address ? id2Address->find(address) : addressIndex->find(address);
+    }
+};
+
 static argparse::ArgumentParser createArgumentParser();
 static std::vector<ExchangeWalletEntry> readExchangeWalletEntries(const std::string& filePath);
 static std::vector<ExchangeWalletMatchResult> matchExchangeWalletEntries(
     uint32_t workerIndex,
     const std::vector<ExchangeWalletEntry>* entries,
-    const std::map<std::string, BtcId>* addr2Ids,
-    const utils::btc::WeightedQuickUnion* quickUnion
+    const AddressFinder* addr2Ids,
+    const utils::btc::UnionFindView* quickUnion
 );
 
 auto& logger = getLogger();
@@ -74,13 +94,31 @@ int main(int argc, char* argv[]) {
         const auto& taskChunks = utils::generateTaskChunks<ExchangeWalletEntry>(exchangeWalletEntries, workerCount);
 
         std::string id2AddressFilePath = argumentParser.get("id2addr");
-        logger.info(fmt::format("Load address2Id from {}...", id2AddressFilePath));
-        const auto& addr2Ids = utils::btc::loadAddress2Id(id2AddressFilePath.c_str());
+        std::unique_ptr<utils::btc::AddressIndex> addressIndex;
+        std::unique_ptr<utils::btc::Id2AddressView> id2Address;
+        uint64_t addressCount;
+        if (utils::btc::isBinaryId2AddressPath(id2AddressFilePath)) {
+            logger.info(fmt::format("Map id2addr from {}...", id2AddressFilePath));
+            id2Address = std::make_unique<utils::btc::Id2AddressView>(id2AddressFilePath);
+            if (!id2Address->hasHashIndex()) {
+                throw std::runtime_error(fmt::format("Id2addr file {} has no hash index", id2AddressFilePath));
+            }
+            addressCount = id2Address->size();
+        }
+        else {
+            logger.info(fmt::format("Load address2Id from {}...", id2AddressFilePath));
+            addressIndex = std::make_unique<utils::btc::AddressIndex>(utils::btc::AddressIndex::load(id2AddressFilePath));
+            addressCount = addressIndex->size();
+        }
+
+        auto bloomFilter = utils::btc::AddressBloomFilter::loadOf(id2AddressFilePath, addressCount);
+        logger.info(fmt::format("Loaded address2Id: {} items, bloom filter: {}", addressCount, bloomFilter != nullptr));
         logUsedMemory();
 
+        AddressFinder addr2Ids { addressIndex.get(), id2Address.get(), bloomFilter.get() };
+
         std::string unionFindFilePath = argumentParser.get("uf_file");
-        utils::btc::WeightedQuickUnion quickUnion(1);
-        quickUnion.load(unionFindFilePath);
+        utils::btc::UnionFindView quickUnion(unionFindFilePath);
 
         logger.info(fmt::format("Loaded ids: {}", quickUnion.getSize()));
         logger.info(fmt::format("Loaded cluster count: {}", quickUnion.getClusterCount()));
@@ -132,7 +170,7 @@ static argparse::ArgumentParser createArgumentParser() {
     argparse::ArgumentParser program("btc_match_exchange_address");
 
     program.add_argument("id2addr")
-        .help("Id2address file")
+        .help("Id2address file, a binary one (.bin) needs a hash index. <id2addr>.bloom is used if it matches")
         .required();
 
     program.add_argument("uf_file")
@@ -177,19 +215,18 @@ std::vector<ExchangeWalletEntry> readExchangeWalletEntries(const std::string& fi
 static std::vector<ExchangeWalletMatchResult> matchExchangeWalletEntries(
     uint32_t workerIndex,
     const std::vector<ExchangeWalletEntry>* entries,
-    const std::map<std::string, BtcId>* addr2Ids,
-    const utils::btc::WeightedQuickUnion* quickUnion
+    const AddressFinder* addr2Ids,
+    const utils::btc::UnionFindView* quickUnion
 ) {
     std::vector<ExchangeWalletMatchResult> matchResults;
     for (const auto& entry : *entries) {
-        auto addressIdIt = addr2Ids->find(entry.sampleAddress);
-        if (addressIdIt == addr2Ids->end()) {
+        BtcId addressId = addr2Ids->find(entry.sampleAddress);
+        if (addressId == utils::btc::AddressIndex::NO_ID) {
             logger.error(fmt::format("Can't find address: {}", entry.sampleAddress));
 
             continue;
         }
 
-        BtcId addressId = addressIdIt->second;
         BtcId addressClusterId = quickUnion->findRoot(addressId);
         BtcSize addressClusterSize = quickUnion->getClusterSize(addressClusterId);
 
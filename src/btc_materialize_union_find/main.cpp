@@ -0,0 +1,107 @@
+// 根据合并日志生成截止到指定日期的聚类结果
+
+#include "btc-config.h"
+#include "btc_materialize_union_find/logger.h"
+
+#include "utils/mem_utils.h"
+#include "utils/union_find.h"
+#include "fmt/format.h"
+#include <argparse/argparse.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <filesystem>
+#include <map>
+
+namespace fs = std::filesystem;
+
+static argparse::ArgumentParser createArgumentParser();
+
+inline void logUsedMemory();
+
+auto& logger = getLogger();
+
+int main(int argc, char* argv[]) {
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
+    }
+
+    try {
+        std::string unionLogFilePath = argumentParser.get("union_log");
+        logger.info(fmt::format("Load union log from {}", unionLogFilePath));
+        utils::btc::UnionLog unionLog(unionLogFilePath);
+        logger.info(fmt::format("Loaded days: {}, ids: {}", unionLog.getDays().size(), unionLog.getIdCount()));
+
+        std::map<uint32_t, std::vector<std::string>> cutoffsByDayIndex;
+        for (const auto& cutoffDay : argumentParser.get<std::vector<std::string>>("--cutoffs")) {
+            uint32_t dayIndex = unionLog.findDayIndex(cutoffDay);
+            if (dayIndex == utils::btc::UnionLog::NO_DAY) {
+                logger.warning(fmt::format("No day before cutoff {}, every address is its own entity", cutoffDay));
+            }
+            else {
+                logger.info(fmt::format("Cutoff {} ends at day {}", cutoffDay, unionLog.getDays()[dayIndex]));
+            }
+
+            cutoffsByDayIndex[dayIndex].push_back(cutoffDay);
+        }
+
+        std::vector<uint32_t> cutoffDayIndexes;
+        for (const auto& [dayIndex, cutoffDays] : cutoffsByDayIndex) {
+            cutoffDayIndexes.push_back(dayIndex);
+        }
+
+        fs::path outputDirPath = argumentParser.get("output_dir");
+        fs::create_directories(outputDirPath);
+
+        unionLog.materialize(cutoffDayIndexes, [&](uint32_t dayIndex, const utils::btc::WeightedQuickUnion& quickUnion) {
+            for (const auto& cutoffDay : cutoffsByDayIndex[dayIndex]) {
+                auto outputFilePath = outputDirPath / fmt::format("{}.uf", cutoffDay);
+                logger.info(fmt::format(
+                    "Dump {} entities as of {} to {}", quickUnion.getClusterCount(), cutoffDay, outputFilePath.string()
+                ));
+
+                quickUnion.save(outputFilePath);
+            }
+
+            logUsedMemory();
+        });
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        logger.error(e.what());
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_materialize_union_find");
+
+    program.add_argument("union_log")
+        .required()
+        .help("Union log file written by btc_union_find --union_log");
+
+    program.add_argument("output_dir")
+        .required()
+        .help("Directory of <cutoff>.uf result files");
+
+    program.add_argument("--cutoffs")
+        .help("Last day names to include, such as 2019-12-31")
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .required();
+
+    return program;
+}
+
+inline void logUsedMemory() {
+    auto usedMemory = utils::mem::getAllocatedMemory();
+    logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
+}
@@ -4,44 +4,54 @@
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
 #include "fmt/format.h"
+#include <argparse/argparse.hpp>
 
 #include <cstdlib>
 #include <iostream>
+#include <thread>
+
+static argparse::ArgumentParser createArgumentParser();
+void mergeQuickUnions(const std::string& mergedFilePath, const std::vector<std::string>& unionFindFilePaths);
+void mergeQuickUnionsByStreaming(
+    const std::string& mergedFilePath,
+    const std::vector<std::string>& unionFindFilePaths,
+    uint32_t workerCount
+);
 
 inline void logUsedMemory();
 
 auto& logger = getLogger();
 
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Invalid arguments!\n\nUsage: btc_merge_union_find <merged_ufs> <ufs>n" << std::endl;
-
-        return EXIT_FAILURE;
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
     }
 
     try {
-        int32_t inputFileCount = argc - 2;
-        logger.info(fmt::format("UF file count: {}", inputFileCount));
-
-        utils::btc::WeightedQuickUnion mergedQuickUnion(1);
-        for (int32_t inputFileIndex = 0; inputFileIndex != inputFileCount; ++inputFileIndex) {
-            const char* unionFindFilePath = argv[inputFileIndex + 2];
-            logger.info(fmt::format("Merge union find form {}", unionFindFilePath));
-
-            utils::btc::WeightedQuickUnion quickUnion(1);
-            quickUnion.load(unionFindFilePath);
-
-            if (inputFileIndex == 0) {
-                mergedQuickUnion = quickUnion;
-            }
-            else {
-                mergedQuickUnion.merge(quickUnion);
-            }
+        const auto& unionFindFilePaths = argumentParser.get<std::vector<std::string>>("ufs");
+        logger.info(fmt::format("UF file count: {}", unionFindFilePaths.size()));
+
+        std::string mergedFilePath = argumentParser.get("merged_uf");
+        if (argumentParser.get<bool>("--streaming")) {
+            uint32_t workerCount = std::min(
+                argumentParser.get<uint32_t>("--worker_count"),
+                std::thread::hardware_concurrency()
+            );
+            logger.info(fmt::format("Worker count: {}", workerCount));
+
+            mergeQuickUnionsByStreaming(mergedFilePath, unionFindFilePaths, workerCount);
+        }
+        else {
+            mergeQuickUnions(mergedFilePath, unionFindFilePaths);
         }
 
-        const char* mergedFilePath = argv[1];
-        logger.info(fmt::format("Dump merged file to: {}", mergedFilePath));
-        mergedQuickUnion.save(mergedFilePath);
+        logUsedMemory();
     }
     catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -51,6 +61,69 @@ int main(int argc, char* argv[]) {
     return EXIT_SUCCESS;
 }
 
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_merge_union_find");
+
+    program.add_argument("merged_uf")
+        .required()
+        .help("The file path of merged union find");
+
+    program.add_argument("ufs")
+        .help("Union find files to merge")
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .required();
+
+    program.add_argument("--streaming")
+        .help("Stream ids of every file into one concurrent union find instead of loading and merging them one by one")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("-w", "--worker_count")
+        .help("Max worker count of streaming merge")
+        .scan<'d', uint32_t>()
+        .default_value(1u);
+
+    return program;
+}
+
+void mergeQuickUnions(const std::string& mergedFilePath, const std::vector<std::string>& unionFindFilePaths) {
+    utils::btc::WeightedQuickUnion mergedQuickUnion(1);
+    bool isFirstFile = true;
+    for (const auto& unionFindFilePath : unionFindFilePaths) {
+        logger.info(fmt::format("Merge union find form {}", unionFindFilePath));
+
+        utils::btc::WeightedQuickUnion quickUnion(1);
+        quickUnion.load(unionFindFilePath);
+
+        if (isFirstFile) {
+            mergedQuickUnion = std::move(quickUnion);
+            isFirstFile = false;
+        }
+        else {
+            mergedQuickUnion.merge(quickUnion);
+        }
+    }
+
+    logger.info(fmt::format("Dump merged file to: {}", mergedFilePath));
+    mergedQuickUnion.save(mergedFilePath);
+}
+
+void mergeQuickUnionsByStreaming(
+    const std::string& mergedFilePath,
+    const std::vector<std::string>& unionFindFilePaths,
+    uint32_t workerCount
+) {
+    utils::btc::ConcurrentQuickUnion mergedQuickUnion(0);
+    for (const auto& unionFindFilePath : unionFindFilePaths) {
+        logger.info(fmt::format("Stream union find form {}", unionFindFilePath));
+        mergedQuickUnion.merge(unionFindFilePath, workerCount);
+        logUsedMemory();
+    }
+
+    logger.info(fmt::format("Dump merged file to: {}", mergedFilePath));
+    mergedQuickUnion.save(mergedFilePath, workerCount);
+}
+
 inline void logUsedMemory() {
     auto usedMemory = utils::mem::getAllocatedMemory();
     logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
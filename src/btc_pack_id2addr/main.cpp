@@ -0,0 +1,99 @@
+// 将文本id2addr转换为可直接映射的二进制id2addr
+
+#include "btc-config.h"
+#include "btc_pack_id2addr/logger.h"
+
+#include "utils/id2address.h"
+#include "utils/address_bloom_filter.h"
+#include "utils/mem_utils.h"
+#include "fmt/format.h"
+#include <argparse/argparse.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static argparse::ArgumentParser createArgumentParser();
+
+inline void logUsedMemory();
+
+auto& logger = getLogger();
+
+int main(int argc, char* argv[]) {
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
+    }
+
+    try {
+        std::string id2AddressFilePath = argumentParser.get("id2addr");
+        logger.info(fmt::format("Map id2addr from {}", id2AddressFilePath));
+        utils::btc::Id2AddressView id2Address(id2AddressFilePath);
+        logger.info(fmt::format("Mapped id2addr: {} items", id2Address.size()));
+
+        logUsedMemory();
+
+        std::string outputFilePath = argumentParser.get("output_file");
+        bool withHashIndex = argumentParser.get<bool>("--hash_index");
+        logger.info(fmt::format("Dump binary id2addr to {}, hash index: {}", outputFilePath, withHashIndex));
+        id2Address.dump(outputFilePath, withHashIndex);
+
+        logUsedMemory();
+
+        if (argumentParser.get<bool>("--bloom_filter")) {
+            // 查找前先过滤掉肯定不存在的地址，不必访问映射的哈希索引
+            utils::btc::AddressBloomFilter bloomFilter(id2Address.size());
+            for (BtcId addressId = 0; addressId != id2Address.size(); ++addressId) {
+                bloomFilter.insert(id2Address.getAddress(addressId));
+            }
+
+            std::string bloomFilterFilePath = utils::btc::AddressBloomFilter::getFilePath(outputFilePath);
+            logger.info(fmt::format("Dump bloom filter to {}", bloomFilterFilePath));
+            bloomFilter.saveOf(outputFilePath);
+
+            logUsedMemory();
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        logger.error(e.what());
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_pack_id2addr");
+
+    program.add_argument("id2addr")
+        .required()
+        .help("The file path of the text id2addr");
+
+    program.add_argument("output_file")
+        .required()
+        .help("Output file path of the binary id2addr, use the .bin extension");
+
+    program.add_argument("--hash_index")
+        .help("Also write a hash index for address to id lookups")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--bloom_filter")
+        .help("Also write a bloom filter of the addresses to <output_file>.bloom, lookups use it to skip unknown addresses")
+        .default_value(false)
+        .implicit_value(true);
+
+    return program;
+}
+
+inline void logUsedMemory() {
+    auto usedMemory = utils::mem::getAllocatedMemory();
+    logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
+}
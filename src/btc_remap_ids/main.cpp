@@ -0,0 +1,240 @@
+// 将按旧id2addr编号的聚类结果和id列表转换为新id2addr的编号
+// 其他带id的文件（converted blocks、day inputs、bitset等）不做转换，需要按新id2addr重新生成
+
+#include "btc-config.h"
+#include "btc_remap_ids/logger.h"
+
+#include "utils/io_utils.h"
+#include "utils/mem_utils.h"
+#include "utils/btc_utils.h"
+#include "utils/union_find.h"
+#include "utils/line_loader.h"
+#include "fmt/format.h"
+#include <argparse/argparse.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static argparse::ArgumentParser createArgumentParser();
+
+std::vector<BtcIdStorage> generateIdMapping(
+    const std::string& oldId2AddressFilePath,
+    const std::string& newId2AddressFilePath
+);
+
+void remapUnionFind(
+    const std::vector<BtcIdStorage>& idMapping,
+    const fs::path& unionFindFilePath,
+    const fs::path& outputFilePath
+);
+
+void remapIdList(
+    const std::vector<BtcIdStorage>& idMapping,
+    const fs::path& idListFilePath,
+    const fs::path& outputFilePath
+);
+
+inline void logUsedMemory();
+
+auto& logger = getLogger();
+
+int main(int argc, char* argv[]) {
+    auto argumentParser = createArgumentParser();
+    try {
+        argumentParser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err) {
+        logger.error(err.what());
+        std::cerr << argumentParser;
+        std::exit(1);
+    }
+
+    try {
+        auto idMapping = generateIdMapping(argumentParser.get("old_id2addr"), argumentParser.get("new_id2addr"));
+        logUsedMemory();
+
+        fs::path outputDirPath = argumentParser.get("output_dir");
+        fs::create_directories(outputDirPath);
+
+        for (const auto& unionFindFilePath : argumentParser.get<std::vector<std::string>>("--ufs")) {
+            remapUnionFind(idMapping, unionFindFilePath, outputDirPath / fs::path(unionFindFilePath).filename());
+            logUsedMemory();
+        }
+
+        for (const auto& idListFilePath : argumentParser.get<std::vector<std::string>>("--id_lists")) {
+            remapIdList(idMapping, idListFilePath, outputDirPath / fs::path(idListFilePath).filename());
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        logger.error(e.what());
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static argparse::ArgumentParser createArgumentParser() {
+    argparse::ArgumentParser program("btc_remap_ids");
+
+    program.add_argument("old_id2addr")
+        .required()
+        .help("id2addr file the inputs are numbered by");
+
+    program.add_argument("new_id2addr")
+        .required()
+        .help("id2addr file to renumber to, such as one written by btc_gen_address --order first_seen");
+
+    program.add_argument("output_dir")
+        .required()
+        .help("Directory of remapped files, which keep their file names");
+
+    program.add_argument("--ufs")
+        .help("Union find files")
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>());
+
+    program.add_argument("--id_lists")
+        .help("Text files with an id at the start of every line, such as id or id,value lines. "
+            "Other id files (converted blocks, day inputs, bitsets) are refused, regenerate them from the new id2addr")
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>());
+
+    return program;
+}
+
+std::vector<BtcIdStorage> generateIdMapping(
+    const std::string& oldId2AddressFilePath,
+    const std::string& newId2AddressFilePath
+) {
+    logger.info(fmt::format("Load new id2addr from {}", newId2AddressFilePath));
+    std::vector<std::string> newId2Address = utils::btc::loadId2Address(newId2AddressFilePath.c_str());
+
+    std::unordered_map<std::string_view, BtcId> newAddress2Id;
+    newAddress2Id.reserve(newId2Address.size());
+    for (BtcId addressId = 0; addressId != newId2Address.size(); ++addressId) {
+        newAddress2Id[newId2Address[addressId]] = addressId;
+    }
+    logUsedMemory();
+
+    logger.info(fmt::format("Load old id2addr from {}", oldId2AddressFilePath));
+    std::vector<std::string> oldId2Address = utils::btc::loadId2Address(oldId2AddressFilePath.c_str());
+    if (oldId2Address.size() != newId2Address.size()) {
+        throw std::runtime_error(fmt::format(
+            "Address count mismatch, old: {}, new: {}", oldId2Address.size(), newId2Address.size()
+        ));
+    }
+
+    std::vector<BtcIdStorage> idMapping(oldId2Address.size());
+    for (BtcId addressId = 0; addressId != oldId2Address.size(); ++addressId) {
+        auto newAddressIt = newAddress2Id.find(oldId2Address[addressId]);
+        if (newAddressIt == newAddress2Id.cend()) {
+            throw std::runtime_error(fmt::format("Address not in new id2addr: {}", oldId2Address[addressId]));
+        }
+
+        idMapping[addressId] = newAddressIt->second;
+    }
+
+    logger.info(fmt::format("Generated id mapping of {} addresses", idMapping.size()));
+
+    return idMapping;
+}
+
+void remapUnionFind(
+    const std::vector<BtcIdStorage>& idMapping,
+    const fs::path& unionFindFilePath,
+    const fs::path& outputFilePath
+) {
+    logger.info(fmt::format("Load union find from {}", unionFindFilePath.string()));
+
+    std::vector<std::string> appliedDays;
+    utils::btc::RankedQuickUnion quickUnion(1);
+    quickUnion.load(unionFindFilePath, appliedDays);
+
+    BtcId idCount = quickUnion.getSize();
+    if (idCount > idMapping.size()) {
+        throw std::runtime_error(fmt::format(
+            "Union find {} has {} ids, more than {} addresses", unionFindFilePath.string(), idCount, idMapping.size()
+        ));
+    }
+
+    // 只保留聚类关系，新的树结构按新编号重新合并
+    // New ids go up to the address count, ids the file didn't cover stay single
+    utils::btc::RankedQuickUnion remappedQuickUnion(idMapping.size());
+    for (BtcId addressId = 0; addressId != idCount; ++addressId) {
+        BtcId rootId = quickUnion.findRoot(addressId);
+        if (rootId != addressId) {
+            remappedQuickUnion.connect(idMapping[addressId], idMapping[rootId]);
+        }
+    }
+
+    logger.info(fmt::format(
+        "Dump {} entities to {}", remappedQuickUnion.getClusterCount(), outputFilePath.string()
+    ));
+    remappedQuickUnion.save(outputFilePath, appliedDays);
+}
+
+void remapIdList(
+    const std::vector<BtcIdStorage>& idMapping,
+    const fs::path& idListFilePath,
+    const fs::path& outputFilePath
+) {
+    logger.info(fmt::format("Remap id list {} to {}", idListFilePath.string(), outputFilePath.string()));
+
+    // 二进制和JSON文件里的id无法按行替换，直接拒绝，避免输出混合两种编号的文件
+    auto extension = idListFilePath.extension();
+    if (extension == ".bin" || extension == ".json" || extension == ".uf") {
+        throw std::runtime_error(fmt::format(
+            "{} is not a text id list, regenerate it from the new id2addr instead", idListFilePath.string()
+        ));
+    }
+
+    std::ifstream idListFile(idListFilePath);
+    if (!idListFile.is_open()) {
+        throw std::runtime_error(fmt::format("Can not open id list {}", idListFilePath.string()));
+    }
+
+    std::ofstream outputFile(outputFilePath);
+    std::string line;
+    size_t lineCount = 0;
+    while (std::getline(idListFile, line)) {
+        if (!line.size()) {
+            continue;
+        }
+
+        if (line.back() == '\r') {
+            line.pop_back();
+        }
+
+        // A line which doesn't start with a plain id means the file isn't an id list
+        auto idEnd = line.find(',');
+        BtcId addressId = utils::parseNumber<BtcId>(std::string_view(line).substr(0, idEnd), idListFilePath.string());
+        if (addressId >= idMapping.size()) {
+            throw std::runtime_error(fmt::format("Id {} out of range in {}", addressId, idListFilePath.string()));
+        }
+
+        outputFile << static_cast<BtcId>(idMapping[addressId]);
+        if (idEnd != std::string::npos) {
+            outputFile << std::string_view(line).substr(idEnd);
+        }
+        outputFile << '\n';
+
+        ++lineCount;
+    }
+
+    logger.info(fmt::format("Remapped {} lines", lineCount));
+}
+
+inline void logUsedMemory() {
+    auto usedMemory = utils::mem::getAllocatedMemory();
+    logger.debug(fmt::format("Used memory: {}GB {}MB", usedMemory / 1024 / 1024, usedMemory / 1024));
+}
@@ -29,7 +29,7 @@ int main(int argc, char* argv[]) {
         const char* unionFindFilePath = argv[1];
         logger.info(fmt::format("Load union find form {}", unionFindFilePath));
 
-        utils::btc::WeightedQuickUnion quickUnion(1);
+        utils::btc::RankedQuickUnion quickUnion(1);
         quickUnion.load(unionFindFilePath);
 
         logger.info(fmt::format("Loaded ids: {}", quickUnion.getSize()));
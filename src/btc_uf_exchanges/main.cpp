@@ -4,11 +4,14 @@
 #include "logging/Logger.h"
 #include "logging/handlers/FileHandler.h"
 #include "utils/io_utils.h"
+#include "utils/line_loader.h"
 #include "utils/task_utils.h"
 #include "utils/json_utils.h"
 #include "utils/btc_utils.h"
+#include "utils/id2address.h"
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/entity_index.h"
 #include "fmt/format.h"
 #include <nlohmann/json.hpp>
 
@@ -22,6 +25,8 @@
 #include <filesystem>
 #include <thread>
 #include <iostream>
+#include <memory>
+#include <algorithm>
 
 using json = nlohmann::json;
 
@@ -46,19 +51,14 @@ int main(int argc, char* argv[]) {
     
     const char* ufFilePath = argv[1];
     logger.info(fmt::format("Load union find file from {}", ufFilePath));
-    utils::btc::WeightedQuickUnion uf(1);
-    uf.load(ufFilePath);
+    utils::btc::UnionFindView uf(ufFilePath);
+    logger.info(fmt::format("Mapped ids: {}, frozen roots: {}", uf.getSize(), uf.hasFrozenRoots()));
 
     logUsedMemory();
 
     logger.info("Loading exchange address ids");
     const char* exchangeAddressIdsFilePath = argv[2];
-    std::vector<BtcId> addressIds = utils::readLines<std::vector<BtcId>, BtcId>(
-        exchangeAddressIdsFilePath,
-        [](const std::string& line) -> BtcId {
-            return std::stoi(line);
-        }
-    );
+    std::vector<BtcId> addressIds = utils::loadNumberLines<BtcId>(exchangeAddressIdsFilePath);
 
     logUsedMemory();
 
@@ -72,11 +72,23 @@ int main(int argc, char* argv[]) {
     logger.info("Generating all address ids by union find");
 
     std::vector<BtcId> unionFoundExchangedAddressIds;
-    auto maxId = uf.getSize();
-    for (BtcId currentId = 0; currentId < maxId; ++currentId) {
-        BtcId currentRoot = uf.findRoot(currentId);
-        if (exchangeRootAddresseIds.contains(currentRoot)) {
-            unionFoundExchangedAddressIds.push_back(currentId);
+    auto entityIndex = utils::btc::loadEntityIndexOf(uf);
+    if (entityIndex) {
+        logger.info(fmt::format("Expand exchange entities by entity index of {}", ufFilePath));
+        for (BtcId rootId : exchangeRootAddresseIds) {
+            for (BtcId addressId : entityIndex->getMembersOfRoot(rootId)) {
+                unionFoundExchangedAddressIds.push_back(addressId);
+            }
+        }
+        std::sort(unionFoundExchangedAddressIds.begin(), unionFoundExchangedAddressIds.end());
+    }
+    else {
+        auto maxId = uf.getSize();
+        for (BtcId currentId = 0; currentId < maxId; ++currentId) {
+            BtcId currentRoot = uf.findRoot(currentId);
+            if (exchangeRootAddresseIds.contains(currentRoot)) {
+                unionFoundExchangedAddressIds.push_back(currentId);
+            }
         }
     }
 
@@ -86,15 +98,14 @@ int main(int argc, char* argv[]) {
 
     if (argc > 5) {
         const char* address2IdFilePath = argv[4];
-        logger.info("Load id2Address...");
-        auto id2Address = utils::btc::loadId2Address(address2IdFilePath);
-        logger.info(fmt::format("Loaded id2Address: {} items", id2Address.size()));
+        logger.info("Map id2Address...");
+        utils::btc::Id2AddressView id2Address(address2IdFilePath);
+        logger.info(fmt::format("Mapped id2Address: {} items", id2Address.size()));
 
         const char* unionFoundExchangedAddressesFilePath = argv[5];
         std::vector<std::string> unionFoundExchangedAddresses;
         for (BtcId addressId : unionFoundExchangedAddressIds) {
-            const std::string exchangeAddress = id2Address[addressId];
-            unionFoundExchangedAddresses.push_back(exchangeAddress);
+            unionFoundExchangedAddresses.push_back(std::string(id2Address[addressId]));
         }
 
         utils::writeLines(unionFoundExchangedAddressesFilePath, unionFoundExchangedAddresses);
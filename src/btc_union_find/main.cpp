@@ -9,6 +9,9 @@
 #include "utils/btc_utils.h"
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/cluster_heuristics.h"
+#include "utils/day_inputs.h"
+#include "utils/id_bitset.h"
 #include "fmt/format.h"
 #include <nlohmann/json.hpp>
 #include <argparse/argparse.hpp>
@@ -24,43 +27,118 @@
 #include <thread>
 #include <iostream>
 #include <memory>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
 static argparse::ArgumentParser createArgumentParser();
 
 using json = nlohmann::json;
-using WeightedQuickUnionPtr = std::shared_ptr<utils::btc::WeightedQuickUnion>;
+template <typename QuickUnion>
+using QuickUnionPtr = std::shared_ptr<QuickUnion>;
+
+// Unions of a day come from day inputs files, or from converted blocks run through the heuristics
+struct DayUnionSource {
+    std::string fileName;
+    const utils::btc::ClusterHeuristics* heuristics;
+};
 
 inline BtcId parseMaxId(const char* maxIdArg);
 
-std::unique_ptr<std::vector<WeightedQuickUnionPtr>> unionFindByWorkers(
+int dispatchUnionFind(
+    const argparse::ArgumentParser& argumentParser,
+    const std::vector<std::string>& daysList,
+    const DayUnionSource& dayUnionSource
+);
+
+template <typename QuickUnion>
+std::unique_ptr<std::vector<QuickUnionPtr<QuickUnion>>> unionFindByWorkers(
+    BtcId maxId,
+    const std::vector<std::string>& daysList,
+    uint32_t initialWorkerCount,
+    const DayUnionSource& dayUnionSource,
+    std::vector<std::string>& appliedDays
+);
+
+template <typename QuickUnion>
+int unionFindInParallel(
     BtcId maxId,
     const std::vector<std::string>& daysList,
     uint32_t initialWorkerCount,
-    const std::string& dayInputsFileName
+    uint32_t maxMergeWorkerCount,
+    const DayUnionSource& dayUnionSource,
+    const std::string& resultFilePath,
+    bool withFrozenRoots
+);
+
+template <typename QuickUnion>
+int unionFindIncrementally(
+    BtcId maxId,
+    const std::vector<std::string>& daysList,
+    const DayUnionSource& dayUnionSource,
+    const std::string& baseFilePath,
+    const std::string& resultFilePath,
+    uint32_t checkpointDays,
+    bool withFrozenRoots
 );
 
-std::vector<WeightedQuickUnionPtr> mergeQuickUnionsByWorkers(
-    std::unique_ptr<std::vector<WeightedQuickUnionPtr>>& quickFindUnions,
+template <typename QuickUnion>
+std::vector<QuickUnionPtr<QuickUnion>> mergeQuickUnionsByWorkers(
+    std::unique_ptr<std::vector<QuickUnionPtr<QuickUnion>>>& quickFindUnions,
     uint32_t maxMergeWorkerCount
 );
 
-WeightedQuickUnionPtr unionFindTxInputsOfDays(
+template <typename QuickUnion>
+QuickUnionPtr<QuickUnion> unionFindTxInputsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
     BtcId maxId,
-    const std::string& dayInputsFileName
+    const DayUnionSource& dayUnionSource,
+    std::vector<std::string>* appliedDays
+);
+
+int unionFindVersioned(
+    BtcId maxId,
+    std::vector<std::string> daysList,
+    const DayUnionSource& dayUnionSource,
+    const std::string& unionLogFilePath,
+    const std::string& resultFilePath,
+    bool withFrozenRoots
+);
+
+int unionFindExternally(
+    BtcId maxId,
+    const std::vector<std::string>& daysList,
+    const DayUnionSource& dayUnionSource,
+    const std::string& resultFilePath,
+    uint32_t edgeBufferMb
 );
 
-void unionFindTxInputsOfDay(
+template <typename QuickUnion>
+bool unionFindTxInputsOfDay(
     const std::string& dayDir,
-    WeightedQuickUnionPtr quickUnion,
-    const std::string& dayInputsFileName
+    QuickUnion& quickUnion,
+    const DayUnionSource& dayUnionSource
 );
 
-WeightedQuickUnionPtr moveMergeQuickUnions(
-    std::vector<WeightedQuickUnionPtr>* quickUnions
+template <typename QuickUnion>
+void unionFindBlocksOfDay(
+    const std::string& dayDir,
+    QuickUnion& quickUnion,
+    const DayUnionSource& dayUnionSource
+);
+
+template <typename QuickUnion>
+void saveQuickUnion(
+    QuickUnionPtr<QuickUnion> quickUnion,
+    const std::vector<std::string>& appliedDays,
+    const std::string& filePath,
+    bool withFrozenRoots = false
+);
+
+template <typename QuickUnion>
+QuickUnionPtr<QuickUnion> moveMergeQuickUnions(
+    std::vector<QuickUnionPtr<QuickUnion>>* quickUnions
 );
 
 inline void logUsedMemory();
@@ -83,22 +161,129 @@ int main(int argc, char* argv[]) {
     const std::vector<std::string>& daysList = utils::readLines(daysListFilePath);
     logger.info(fmt::format("Read tasks count: {}", daysList.size()));
 
+    DayUnionSource dayUnionSource{ argumentParser.get("--day_ins_file"), nullptr };
+
+    std::unique_ptr<utils::btc::ClusterHeuristics> heuristics;
+    utils::btc::IdBitset excludeAddresses;
+    auto heuristicNames = argumentParser.get<std::vector<std::string>>("--heuristics");
+    if (!heuristicNames.empty()) {
+        try {
+            // 与btc_gen_day_ins相同，排除涉及交易所地址的交易
+            const std::string excludeAddressListFilePath = argumentParser.get("--exclude_addrs");
+            if (!excludeAddressListFilePath.empty()) {
+                logger.info(fmt::format("Load excludeAddresses: {}", excludeAddressListFilePath));
+                excludeAddresses = utils::btc::IdBitset::loadIdList(excludeAddressListFilePath);
+                logger.info(fmt::format("Loaded excludeAddresses: {}", excludeAddresses.count()));
+            }
+
+            heuristics = std::make_unique<utils::btc::ClusterHeuristics>(
+                heuristicNames,
+                excludeAddressListFilePath.empty() ? nullptr : &excludeAddresses,
+                argumentParser.get<bool>("--exclude_inputs")
+            );
+        }
+        catch (const std::exception& e) {
+            logger.error(e.what());
+
+            return EXIT_FAILURE;
+        }
+
+        dayUnionSource = DayUnionSource{ argumentParser.get("--blocks_file"), heuristics.get() };
+        logger.info(fmt::format("Apply heuristics to {}: {}", dayUnionSource.fileName, fmt::join(heuristicNames, ", ")));
+    }
+
+    int exitCode = dispatchUnionFind(argumentParser, daysList, dayUnionSource);
+
+    if (heuristics) {
+        for (const auto& [counterName, counterValue] : heuristics->getCounters()) {
+            logger.info(fmt::format("Heuristic counter {}: {}", counterName, counterValue));
+        }
+    }
+
+    return exitCode;
+}
+
+int dispatchUnionFind(
+    const argparse::ArgumentParser& argumentParser,
+    const std::vector<std::string>& daysList,
+    const DayUnionSource& dayUnionSource
+) {
     BtcId maxId = argumentParser.get<BtcId>("--id_max_value");
     uint32_t initialWorkerCount = argumentParser.get<uint32_t>("--worker_count");
-    std::string dayInputsFileName = argumentParser.get("--day_ins_file");
+    std::string resultFilePath = argumentParser.get("result_file");
+    bool withFrozenRoots = argumentParser.get<bool>("--frozen_roots");
+
+    std::string unionLogFilePath = argumentParser.get("--union_log");
+    if (!unionLogFilePath.empty()) {
+        return unionFindVersioned(
+            maxId, daysList, dayUnionSource, unionLogFilePath, resultFilePath, withFrozenRoots
+        );
+    }
+
+    uint32_t edgeBufferMb = argumentParser.get<uint32_t>("--edge_buffer_mb");
+    if (edgeBufferMb) {
+        if (withFrozenRoots) {
+            logger.warning("Frozen roots are not written by the external union find");
+        }
+
+        return unionFindExternally(maxId, daysList, dayUnionSource, resultFilePath, edgeBufferMb);
+    }
+
+    bool rankedLayout = argumentParser.get("--layout") == "ranked";
+    if (rankedLayout) {
+        logger.info("Use ranked union find layout");
+    }
+
+    if (argumentParser.get<bool>("--incremental")) {
+        auto unionFind = rankedLayout ?
+            unionFindIncrementally<utils::btc::RankedQuickUnion> :
+            unionFindIncrementally<utils::btc::WeightedQuickUnion>;
+
+        return unionFind(
+            maxId,
+            daysList,
+            dayUnionSource,
+            argumentParser.get("--base_uf"),
+            resultFilePath,
+            argumentParser.get<uint32_t>("--checkpoint_days"),
+            withFrozenRoots
+        );
+    }
+
+    uint32_t maxMergeWorkerCount = argumentParser.get<uint32_t>("--merge_worker_count");
+    auto unionFind = rankedLayout ?
+        unionFindInParallel<utils::btc::RankedQuickUnion> :
+        unionFindInParallel<utils::btc::WeightedQuickUnion>;
+
+    return unionFind(
+        maxId, daysList, initialWorkerCount, maxMergeWorkerCount, dayUnionSource, resultFilePath, withFrozenRoots
+    );
+}
 
+template <typename QuickUnion>
+int unionFindInParallel(
+    BtcId maxId,
+    const std::vector<std::string>& daysList,
+    uint32_t initialWorkerCount,
+    uint32_t maxMergeWorkerCount,
+    const DayUnionSource& dayUnionSource,
+    const std::string& resultFilePath,
+    bool withFrozenRoots
+) {
     logUsedMemory();
-    auto quickFindUnions = unionFindByWorkers(maxId, daysList, initialWorkerCount, dayInputsFileName);
+    std::vector<std::string> appliedDays;
+    auto quickFindUnions = unionFindByWorkers<QuickUnion>(
+        maxId, daysList, initialWorkerCount, dayUnionSource, appliedDays
+    );
     logUsedMemory();
 
-    uint32_t maxMergeWorkerCount = argumentParser.get<uint32_t>("--merge_worker_count");
     auto firstMergedQuickFindUnions = mergeQuickUnionsByWorkers(quickFindUnions, maxMergeWorkerCount);
     logUsedMemory();
 
     logger.info("Do final merge");
 
-    WeightedQuickUnionPtr mergedQuickFindUnions = moveMergeQuickUnions(&firstMergedQuickFindUnions);
-    mergedQuickFindUnions->save(argumentParser.get("result_file"));
+    QuickUnionPtr<QuickUnion> mergedQuickFindUnions = moveMergeQuickUnions(&firstMergedQuickFindUnions);
+    saveQuickUnion(mergedQuickFindUnions, appliedDays, resultFilePath, withFrozenRoots);
     logger.info(fmt::format("Found entities: {}", mergedQuickFindUnions->getClusterCount()));
 
     logUsedMemory();
@@ -123,9 +308,28 @@ static argparse::ArgumentParser createArgumentParser() {
         .required();
 
     program.add_argument("--day_ins_file")
-        .help("Filename of day inputs address file")
+        .help("Filename of day inputs address file, .bin files are read as binary day inputs")
         .default_value("day-inputs.json");
 
+    program.add_argument("--heuristics")
+        .help("Cluster by multi_input, round_change and coinjoin on converted blocks instead of reading day inputs "
+            "files. coinjoin always runs first, the others in the given order")
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>());
+
+    program.add_argument("--blocks_file")
+        .help("Filename of converted blocks file used by --heuristics")
+        .default_value("converted-block-list.json");
+
+    program.add_argument("-e", "--exclude_addrs")
+        .help("Exclude addresses file path used by --heuristics, txs paying to them are skipped like in btc_gen_day_ins")
+        .default_value("");
+
+    program.add_argument("--exclude_inputs")
+        .help("With --exclude_addrs, also skip txs spending from excluded addresses")
+        .implicit_value(true)
+        .default_value(false);
+
     program.add_argument("-w", "--worker_count")
         .help("Max worker count")
         .scan<'d', uint32_t>()
@@ -136,14 +340,48 @@ static argparse::ArgumentParser createArgumentParser() {
         .scan<'d', uint32_t>()
         .required();
 
+    program.add_argument("--incremental")
+        .help("Apply only days not recorded in the union find file, resume from result file if it exists")
+        .implicit_value(true)
+        .default_value(false);
+
+    program.add_argument("--base_uf")
+        .help("Union find file to start from in incremental mode")
+        .default_value("");
+
+    program.add_argument("--layout")
+        .help("Union find memory layout: weighted (ids and sizes) or ranked (ids and 1 byte ranks)")
+        .default_value("weighted");
+
+    program.add_argument("--frozen_roots")
+        .help("Also store the root of every id in the result file for fast lookups by memory mapped views")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--edge_buffer_mb")
+        .help("Keep the union find in a memory mapped file and apply edges in sorted batches of this many MB, 0 to run in RAM")
+        .scan<'d', uint32_t>()
+        .default_value(0u);
+
+    program.add_argument("--union_log")
+        .help("Process days in date order on one worker and log every union with its day")
+        .default_value("");
+
+    program.add_argument("--checkpoint_days")
+        .help("Save result file after every N days in incremental mode, 0 to disable")
+        .scan<'d', uint32_t>()
+        .default_value(30u);
+
     return program;
 }
 
-std::unique_ptr<std::vector<WeightedQuickUnionPtr>> unionFindByWorkers(
+template <typename QuickUnion>
+std::unique_ptr<std::vector<QuickUnionPtr<QuickUnion>>> unionFindByWorkers(
     BtcId maxId,
     const std::vector<std::string>& daysList,
     uint32_t initialWorkerCount,
-    const std::string& dayInputsFileName
+    const DayUnionSource& dayUnionSource,
+    std::vector<std::string>& appliedDays
 ) {
 
     uint32_t workerCount = std::min(initialWorkerCount, std::thread::hardware_concurrency());
@@ -151,29 +389,36 @@ std::unique_ptr<std::vector<WeightedQuickUnionPtr>> unionFindByWorkers(
     logger.info(fmt::format("Worker count: {}", workerCount));
 
     const std::vector<std::vector<std::string>> taskChunks = utils::generateTaskChunks(daysList, workerCount);
+    std::vector<std::vector<std::string>> tasksAppliedDays(workerCount);
     uint32_t workerIndex = 0;
-    std::vector<std::future<WeightedQuickUnionPtr>> tasks;
+    std::vector<std::future<QuickUnionPtr<QuickUnion>>> tasks;
     for (const auto& taskChunk : taskChunks) {
+        auto& taskAppliedDays = tasksAppliedDays[workerIndex];
         tasks.push_back(
-            std::async(unionFindTxInputsOfDays, workerIndex, &taskChunk, maxId, dayInputsFileName)
+            std::async(unionFindTxInputsOfDays<QuickUnion>, workerIndex, &taskChunk, maxId, dayUnionSource, &taskAppliedDays)
         );
 
         ++workerIndex;
     }
     utils::waitForTasks(logger, tasks);
 
+    for (const auto& taskAppliedDays : tasksAppliedDays) {
+        appliedDays.insert(appliedDays.end(), taskAppliedDays.begin(), taskAppliedDays.end());
+    }
+
     logUsedMemory();
 
-    auto quickFindUnions = std::make_unique<std::vector<WeightedQuickUnionPtr>>();
+    auto quickFindUnions = std::make_unique<std::vector<QuickUnionPtr<QuickUnion>>>();
     for (auto& task : tasks) {
-        quickFindUnions->push_back(WeightedQuickUnionPtr(std::move(task.get())));
+        quickFindUnions->push_back(QuickUnionPtr<QuickUnion>(std::move(task.get())));
     }
 
     return quickFindUnions;
 }
 
-std::vector<WeightedQuickUnionPtr> mergeQuickUnionsByWorkers(
-    std::unique_ptr<std::vector<WeightedQuickUnionPtr>>& quickFindUnions,
+template <typename QuickUnion>
+std::vector<QuickUnionPtr<QuickUnion>> mergeQuickUnionsByWorkers(
+    std::unique_ptr<std::vector<QuickUnionPtr<QuickUnion>>>& quickFindUnions,
     uint32_t maxMergeWorkerCount
 ) {
     uint32_t firstMergeWorkerCount = std::min(maxMergeWorkerCount, std::thread::hardware_concurrency());
@@ -190,10 +435,10 @@ std::vector<WeightedQuickUnionPtr> mergeQuickUnionsByWorkers(
     logger.info("Generating first merge tasks");
 
     uint32_t firstMergeWorkerIndex = 0;
-    std::vector<std::future<WeightedQuickUnionPtr>> firstMergeTasks;
+    std::vector<std::future<QuickUnionPtr<QuickUnion>>> firstMergeTasks;
     for (auto& taskChunk : firstMergeQuickFindUnionChunks) {
         firstMergeTasks.push_back(
-            std::async(moveMergeQuickUnions, &taskChunk)
+            std::async(moveMergeQuickUnions<QuickUnion>, &taskChunk)
         );
 
         ++firstMergeWorkerIndex;
@@ -202,50 +447,218 @@ std::vector<WeightedQuickUnionPtr> mergeQuickUnionsByWorkers(
 
     logUsedMemory();
 
-    std::vector<WeightedQuickUnionPtr> firstMergedQuickFindUnions;
+    std::vector<QuickUnionPtr<QuickUnion>> firstMergedQuickFindUnions;
     for (auto& task : firstMergeTasks) {
-        firstMergedQuickFindUnions.push_back(WeightedQuickUnionPtr(std::move(task.get())));
+        firstMergedQuickFindUnions.push_back(QuickUnionPtr<QuickUnion>(std::move(task.get())));
     }
 
     return firstMergedQuickFindUnions;
 }
 
-WeightedQuickUnionPtr unionFindTxInputsOfDays(
+template <typename QuickUnion>
+QuickUnionPtr<QuickUnion> unionFindTxInputsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysList,
     BtcId maxId,
-    const std::string& dayInputsFileName
+    const DayUnionSource& dayUnionSource,
+    std::vector<std::string>* appliedDays
 ) {
     logger.info(fmt::format("Worker started: {}", workerIndex));
 
-    auto quickUnion = std::make_shared<utils::btc::WeightedQuickUnion>(maxId);
+    auto quickUnion = std::make_shared<QuickUnion>(maxId);
 
     for (const auto& dayDir : *daysList) {
-        unionFindTxInputsOfDay(dayDir, quickUnion, dayInputsFileName);
+        if (unionFindTxInputsOfDay(dayDir, *quickUnion, dayUnionSource)) {
+            appliedDays->push_back(utils::btc::getDayName(dayDir));
+        }
     }
 
     return quickUnion;
 }
 
-void unionFindTxInputsOfDay(
+template <typename QuickUnion>
+int unionFindIncrementally(
+    BtcId maxId,
+    const std::vector<std::string>& daysList,
+    const DayUnionSource& dayUnionSource,
+    const std::string& baseFilePath,
+    const std::string& resultFilePath,
+    uint32_t checkpointDays,
+    bool withFrozenRoots
+) {
+    // The result file is also the checkpoint, so an interrupted run resumes from it
+    std::string loadFilePath = fs::exists(resultFilePath) ? resultFilePath : baseFilePath;
+
+    auto quickUnion = std::make_shared<QuickUnion>(1);
+    std::vector<std::string> appliedDays;
+    if (loadFilePath.empty()) {
+        logger.info(fmt::format("No base union find, start from {} ids", maxId));
+        quickUnion = std::make_shared<QuickUnion>(maxId);
+    }
+    else {
+        logger.info(fmt::format("Load union find from {}", loadFilePath));
+        quickUnion->load(loadFilePath, appliedDays);
+        logger.info(fmt::format("Loaded ids: {}, applied days: {}", quickUnion->getSize(), appliedDays.size()));
+
+        // Older manifests hold absolute day directories, keep only the day names
+        for (auto& appliedDay : appliedDays) {
+            appliedDay = utils::btc::getDayName(appliedDay);
+        }
+    }
+    logUsedMemory();
+
+    bool resized = false;
+    if (quickUnion->getSize() < maxId) {
+        auto originalSize = quickUnion->getSize();
+        quickUnion->resize(maxId);
+        resized = true;
+        logger.info(fmt::format("Expand union find from {} to {}", originalSize, quickUnion->getSize()));
+    }
+
+    // Days are matched by name, so the data directory can be moved or mounted elsewhere
+    std::set<std::string> appliedDaySet(appliedDays.begin(), appliedDays.end());
+    std::vector<std::string> pendingDays;
+    for (const auto& dayDir : daysList) {
+        if (!appliedDaySet.contains(utils::btc::getDayName(dayDir))) {
+            pendingDays.push_back(dayDir);
+        }
+    }
+    logger.info(fmt::format("Pending days: {}/{}", pendingDays.size(), daysList.size()));
+
+    if (pendingDays.empty() && loadFilePath == resultFilePath && !resized) {
+        logger.info(fmt::format("Union find is up to date: {}", resultFilePath));
+
+        return EXIT_SUCCESS;
+    }
+
+    uint32_t uncheckedDayCount = 0;
+    for (const auto& dayDir : pendingDays) {
+        if (!unionFindTxInputsOfDay(dayDir, *quickUnion, dayUnionSource)) {
+            continue;
+        }
+
+        appliedDays.push_back(utils::btc::getDayName(dayDir));
+        ++uncheckedDayCount;
+
+        if (checkpointDays && uncheckedDayCount == checkpointDays) {
+            logger.info(fmt::format("Save checkpoint after {} applied days", appliedDays.size()));
+            saveQuickUnion(quickUnion, appliedDays, resultFilePath);
+            uncheckedDayCount = 0;
+        }
+    }
+
+    saveQuickUnion(quickUnion, appliedDays, resultFilePath, withFrozenRoots);
+    logger.info(fmt::format("Found entities: {}", quickUnion->getClusterCount()));
+
+    logUsedMemory();
+
+    return EXIT_SUCCESS;
+}
+
+int unionFindVersioned(
+    BtcId maxId,
+    std::vector<std::string> daysList,
+    const DayUnionSource& dayUnionSource,
+    const std::string& unionLogFilePath,
+    const std::string& resultFilePath,
+    bool withFrozenRoots
+) {
+    std::sort(daysList.begin(), daysList.end(), [](const std::string& lhs, const std::string& rhs) {
+        return utils::btc::getDayName(lhs) < utils::btc::getDayName(rhs);
+    });
+
+    logger.info(fmt::format("Write union log to {}", unionLogFilePath));
+    utils::btc::VersionedQuickUnion quickUnion(maxId, unionLogFilePath, daysList);
+    logUsedMemory();
+
+    std::vector<std::string> appliedDays;
+    uint32_t dayCount = daysList.size();
+    for (uint32_t dayIndex = 0; dayIndex != dayCount; ++dayIndex) {
+        const auto& dayDir = daysList[dayIndex];
+
+        quickUnion.beginDay(dayIndex);
+        if (unionFindTxInputsOfDay(dayDir, quickUnion, dayUnionSource)) {
+            appliedDays.push_back(utils::btc::getDayName(dayDir));
+        }
+    }
+    quickUnion.flush();
+    logger.info(fmt::format("Logged unions: {}", quickUnion.getLoggedUnionCount()));
+
+    quickUnion.getQuickUnion().save(resultFilePath, appliedDays, withFrozenRoots);
+    logger.info(fmt::format("Found entities: {}", quickUnion.getQuickUnion().getClusterCount()));
+
+    logUsedMemory();
+
+    return EXIT_SUCCESS;
+}
+
+int unionFindExternally(
+    BtcId maxId,
+    const std::vector<std::string>& daysList,
+    const DayUnionSource& dayUnionSource,
+    const std::string& resultFilePath,
+    uint32_t edgeBufferMb
+) {
+    std::size_t edgeBufferCount = std::size_t(edgeBufferMb) * 1024 * 1024 / sizeof(std::pair<BtcId, BtcId>);
+
+    auto tempFilePath = fmt::format("{}.tmp", resultFilePath);
+    logger.info(fmt::format("Map union find of {} ids to {}, edge buffer: {}", maxId, tempFilePath, edgeBufferCount));
+    utils::btc::ExternalQuickUnion quickUnion(tempFilePath, maxId, edgeBufferCount);
+    logUsedMemory();
+
+    std::vector<std::string> appliedDays;
+    for (const auto& dayDir : daysList) {
+        if (unionFindTxInputsOfDay(dayDir, quickUnion, dayUnionSource)) {
+            appliedDays.push_back(utils::btc::getDayName(dayDir));
+        }
+    }
+
+    quickUnion.close(appliedDays);
+    fs::rename(tempFilePath, resultFilePath);
+    logger.info(fmt::format("Found entities: {}", quickUnion.getClusterCount()));
+
+    logUsedMemory();
+
+    return EXIT_SUCCESS;
+}
+
+template <typename QuickUnion>
+bool unionFindTxInputsOfDay(
     const std::string& dayDir,
-    WeightedQuickUnionPtr quickUnion,
-    const std::string& dayInputsFileName
+    QuickUnion& quickUnion,
+    const DayUnionSource& dayUnionSource
 ) {
     try {
-        auto txInputsOfDayFilePath = fmt::format("{}/{}", dayDir, dayInputsFileName);
-        std::vector<std::vector<std::vector<BtcId>>> txInputsOfDay;
-        utils::btc::loadDayInputs(txInputsOfDayFilePath.c_str(), txInputsOfDay);
-
-        for (const auto& txs : txInputsOfDay) {
-            for (const auto& inputs : txs) {
+        if (dayUnionSource.heuristics) {
+            unionFindBlocksOfDay(dayDir, quickUnion, dayUnionSource);
+        }
+        else if (utils::btc::isBinaryDayInputsPath(dayUnionSource.fileName)) {
+            utils::btc::DayInputsView txInputsOfDay(fs::path(dayDir) / dayUnionSource.fileName);
+            txInputsOfDay.forEachTx([&quickUnion](std::span<const BtcId> inputs) {
                 if (inputs.size() <= 1) {
-                    continue;
+                    return;
                 }
 
-                auto firstId = inputs[0];
-                for (const auto input : inputs) {
-                    quickUnion->connect(firstId, input);
+                for (const auto input : inputs.subspan(1)) {
+                    quickUnion.connect(inputs[0], input);
+                }
+            });
+        }
+        else {
+            auto txInputsOfDayFilePath = fmt::format("{}/{}", dayDir, dayUnionSource.fileName);
+            std::vector<std::vector<std::vector<BtcId>>> txInputsOfDay;
+            utils::btc::loadDayInputs(txInputsOfDayFilePath.c_str(), txInputsOfDay);
+
+            for (const auto& txs : txInputsOfDay) {
+                for (const auto& inputs : txs) {
+                    if (inputs.size() <= 1) {
+                        continue;
+                    }
+
+                    auto firstId = inputs[0];
+                    for (const auto input : inputs) {
+                        quickUnion.connect(firstId, input);
+                    }
                 }
             }
         }
@@ -257,17 +670,67 @@ void unionFindTxInputsOfDay(
     catch (const std::exception& e) {
         logger.error(fmt::format("Error when process blocks by date: {}", dayDir));
         logger.error(e.what());
+
+        return false;
     }
+
+    return true;
+}
+
+template <typename QuickUnion>
+void unionFindBlocksOfDay(
+    const std::string& dayDir,
+    QuickUnion& quickUnion,
+    const DayUnionSource& dayUnionSource
+) {
+    auto blocksFilePath = fmt::format("{}/{}", dayDir, dayUnionSource.fileName);
+    std::ifstream blocksFile(blocksFilePath);
+    if (!blocksFile.is_open()) {
+        throw std::runtime_error(fmt::format("Blocks file not exists: {}", blocksFilePath));
+    }
+
+    json blocks;
+    blocksFile >> blocks;
+
+    // Edges are staged and only connected after every block of the day is parsed, so a day failing
+    // halfway leaves no unions behind and isn't half applied
+    std::vector<std::pair<BtcId, BtcId>> dayEdges;
+    utils::btc::EdgeFunc addEdge = [&dayEdges](BtcId p, BtcId q) {
+        dayEdges.push_back(std::make_pair(p, q));
+    };
+    for (const auto& block : blocks) {
+        dayUnionSource.heuristics->applyToBlock(block, addEdge);
+    }
+
+    for (const auto& [p, q] : dayEdges) {
+        quickUnion.connect(p, q);
+    }
+}
+
+template <typename QuickUnion>
+void saveQuickUnion(
+    QuickUnionPtr<QuickUnion> quickUnion,
+    const std::vector<std::string>& appliedDays,
+    const std::string& filePath,
+    bool withFrozenRoots
+) {
+    // Write aside and rename so a crash never leaves a truncated result
+    auto tempFilePath = fmt::format("{}.tmp", filePath);
+    quickUnion->save(tempFilePath, appliedDays, withFrozenRoots);
+    fs::rename(tempFilePath, filePath);
+
+    logger.info(fmt::format("Saved union find with {} applied days: {}", appliedDays.size(), filePath));
 }
 
-WeightedQuickUnionPtr moveMergeQuickUnions(
-    std::vector<WeightedQuickUnionPtr>* quickUnions
+template <typename QuickUnion>
+QuickUnionPtr<QuickUnion> moveMergeQuickUnions(
+    std::vector<QuickUnionPtr<QuickUnion>>* quickUnions
 ) {
     if (quickUnions->size() == 0) {
-        return WeightedQuickUnionPtr();
+        return QuickUnionPtr<QuickUnion>();
     }
 
-    WeightedQuickUnionPtr finalQuickUnion = (*quickUnions)[0];
+    QuickUnionPtr<QuickUnion> finalQuickUnion = (*quickUnions)[0];
     for (auto quickUnionIt = quickUnions->begin() + 1; quickUnionIt != quickUnions->end(); ++quickUnionIt) {
         auto& quickUnion = *quickUnionIt;
 
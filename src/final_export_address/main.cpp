@@ -5,6 +5,8 @@
 
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/entity_index.h"
+#include "utils/id2address.h"
 #include "utils/io_utils.h"
 #include "utils/task_utils.h"
 #include "utils/json_utils.h"
@@ -49,21 +51,20 @@ int main(int argc, char* argv[]) {
         logUsedMemory();
 
         std::string id2AddressFilePath = argumentParser.get("id2addr");
-        logger.info("Load address2Id...");
-        const auto& address2Id = utils::btc::loadId2Address(id2AddressFilePath.c_str());
-        logger.info(fmt::format("Loaded address2Id: {} items", address2Id.size()));
+        logger.info("Map id2Address...");
+        utils::btc::Id2AddressView id2Address(id2AddressFilePath);
+        logger.info(fmt::format("Mapped id2Address: {} items", id2Address.size()));
 
         logUsedMemory();
 
         std::string quickUnionFilePath = argumentParser.get("--uf_file");
-        utils::btc::WeightedQuickUnion quickUnion(1);
         std::set<BtcId> rootIds;
         std::set<BtcId> expandedAddressIds = minerAddressIds;
         logUsedMemory();
         if (!quickUnionFilePath.empty()) {
-            logger.info(fmt::format("Load quick union file: {}", quickUnionFilePath));
-            quickUnion.load(quickUnionFilePath);
-            logger.info(fmt::format("Loaded quick union file: {}", quickUnionFilePath));
+            logger.info(fmt::format("Map quick union file: {}", quickUnionFilePath));
+            utils::btc::UnionFindView quickUnion(quickUnionFilePath);
+            logger.info(fmt::format("Mapped quick union file: {}", quickUnionFilePath));
 
             // 计算矿工用户集合
             logger.info(fmt::format("Computing miner users"));
@@ -74,11 +75,22 @@ int main(int argc, char* argv[]) {
 
             // 计算矿工地址集合
             logger.info(fmt::format("Computing miner addresses"));
-            auto addressCount = address2Id.size();
-            for (BtcId addressIndex = 0; addressIndex != addressCount; ++addressIndex) {
-                auto rootAddressId = quickUnion.findRoot(addressIndex);
-                if (rootIds.find(rootAddressId) != rootIds.end()) {
-                    expandedAddressIds.insert(addressIndex);
+            auto entityIndex = utils::btc::loadEntityIndexOf(quickUnion);
+            if (entityIndex) {
+                logger.info(fmt::format("Expand miner users by entity index of {}", quickUnionFilePath));
+                for (BtcId rootId : rootIds) {
+                    for (BtcId addressId : entityIndex->getMembersOfRoot(rootId)) {
+                        expandedAddressIds.insert(addressId);
+                    }
+                }
+            }
+            else {
+                BtcId addressCount = id2Address.size();
+                for (BtcId addressIndex = 0; addressIndex != addressCount; ++addressIndex) {
+                    auto rootAddressId = quickUnion.findRoot(addressIndex);
+                    if (rootIds.find(rootAddressId) != rootIds.end()) {
+                        expandedAddressIds.insert(addressIndex);
+                    }
                 }
             }
             logger.info(fmt::format("Finished computing miner addresses"));
@@ -91,12 +103,10 @@ int main(int argc, char* argv[]) {
         std::ofstream outputFile(outputFilePath);
         outputFile << "Address,IsMiner" << std::endl;
 
-        BtcId addressId = 0;
-        for (const std::string& address : address2Id) {
+        BtcId addressCount = id2Address.size();
+        for (BtcId addressId = 0; addressId != addressCount; ++addressId) {
             bool isMinerAddress = expandedAddressIds.find(addressId) != expandedAddressIds.end();
-            outputFile << fmt::format("{},{}", address, isMinerAddress) << std::endl;
-
-            addressId++;
+            outputFile << fmt::format("{},{}", id2Address[addressId], isMinerAddress) << std::endl;
         }
 
         logUsedMemory();
@@ -125,7 +135,7 @@ static argparse::ArgumentParser createArgumentParser() {
         .default_value("");
 
     program.add_argument("--uf_file")
-        .help("The Union find file path")
+        .help("The Union find file path, its entity index from btc_gen_entity_index is used if up to date")
         .default_value("");
 
     return program;
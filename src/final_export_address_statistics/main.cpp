@@ -9,6 +9,7 @@
 #include "utils/task_utils.h"
 #include "utils/json_utils.h"
 #include "utils/btc_utils.h"
+#include "utils/id2address.h"
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
 #include "fmt/format.h"
@@ -50,7 +51,7 @@ static argparse::ArgumentParser createArgumentParser();
 void generateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const utils::btc::WeightedQuickUnion* quickUnion,
+    const utils::btc::RankedQuickUnion* quickUnion,
     CountList* addressCountList,
     CountList* entityCountList,
     CountList* activateEntityCountList
@@ -58,7 +59,7 @@ void generateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfDays(
     const std::string& dayDir,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -66,7 +67,7 @@ void calculateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfBlock(
     const json& block,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -74,7 +75,7 @@ void calculateAddressStatisticsOfBlock(
 
 void calculateAddressStatisticsOfTx(
     const json& tx,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -82,7 +83,7 @@ void calculateAddressStatisticsOfTx(
 
 void processAddress(
     BtcId addressId,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -114,14 +115,14 @@ void dumpSummary(
 
 void dumpNewAddressFile(
     const std::string& outputFilePath,
-    const std::vector<std::string>& id2address,
+    const utils::btc::Id2AddressView& id2address,
     const CountList& prevCountList,
     const CountList& currCountList
 );
 
 void dumpNewEntityFile(
     const std::string& outputFilePath,
-    utils::btc::WeightedQuickUnion& quickUnion,
+    utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const CountList& prevCountList,
     const CountList& currCountList
@@ -129,7 +130,7 @@ void dumpNewEntityFile(
 
 void dumpActivateEntityFile(
     const std::string& outputFilePath,
-    utils::btc::WeightedQuickUnion& quickUnion,
+    utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const CountList& activateEntityCountList
 );
@@ -181,7 +182,7 @@ int main(int argc, char* argv[]) {
     logger.info(fmt::format("Using end year: {}", endYear));
 
     const std::string ufFilePath = argumentParser.get("--union_file");
-    utils::btc::WeightedQuickUnion quickUnion(1);
+    utils::btc::RankedQuickUnion quickUnion(1);
     logger.info(fmt::format("Load quickUnion from {}", ufFilePath));
     quickUnion.load(ufFilePath);
     logger.info(fmt::format("Loaded quickUnion {} items from {}", quickUnion.getSize(), ufFilePath));
@@ -189,9 +190,9 @@ int main(int argc, char* argv[]) {
     logUsedMemory();
 
     std::string id2AddressFilePath = argumentParser.get("id2addr");
-    logger.info("Load address2Id...");
-    const auto& id2Address = utils::btc::loadId2Address(id2AddressFilePath.c_str());
-    logger.info(fmt::format("Loaded id2Address: {} items", id2Address.size()));
+    logger.info("Map id2Address...");
+    utils::btc::Id2AddressView id2Address(id2AddressFilePath);
+    logger.info(fmt::format("Mapped id2Address: {} items", id2Address.size()));
 
     logUsedMemory();
 
@@ -439,7 +440,7 @@ groupDaysListByYears(const std::vector<std::string>& daysList, uint32_t startYea
 void generateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const utils::btc::WeightedQuickUnion* quickUnion,
+    const utils::btc::RankedQuickUnion* quickUnion,
     CountList* addressCountList,
     CountList* entityCountList,
     CountList* activateEntityCountList
@@ -460,7 +461,7 @@ void generateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfDays(
     const std::string& dayDir,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -505,7 +506,7 @@ void calculateAddressStatisticsOfDays(
 
 void calculateAddressStatisticsOfBlock(
     const json& block,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -529,7 +530,7 @@ void calculateAddressStatisticsOfBlock(
 
 void calculateAddressStatisticsOfTx(
     const json& tx,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -577,7 +578,7 @@ void calculateAddressStatisticsOfTx(
 
 void processAddress(
     BtcId addressId,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     CountList& addressCountList,
     CountList& entityCountList,
     CountList& activateEntityCountList
@@ -649,7 +650,7 @@ void dumpSummary(
 
 void dumpNewAddressFile(
     const std::string& outputFilePath,
-    const std::vector<std::string>& id2address,
+    const utils::btc::Id2AddressView& id2address,
     const CountList& prevCountList,
     const CountList& currCountList
 ) {
@@ -666,7 +667,7 @@ void dumpNewAddressFile(
 
 void dumpNewEntityFile(
     const std::string& outputFilePath,
-    utils::btc::WeightedQuickUnion& quickUnion,
+    utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const CountList& prevCountList,
     const CountList& currCountList
@@ -674,7 +675,7 @@ void dumpNewEntityFile(
     logger.info(fmt::format("Dump new entity file to: {}", outputFilePath));
     std::ofstream newEntityFile(outputFilePath.c_str());
 
-    utils::btc::WeightedQuickUnionClusters quickUnionClusters(quickUnion);
+    utils::btc::RankedQuickUnionClusters quickUnionClusters(quickUnion);
     quickUnionClusters.forEach(
         [&newEntityFile, &clusterLabels, &prevCountList, &currCountList](BtcId entityId, BtcId btcSize) -> void {
             if (!prevCountList[entityId] && currCountList[entityId]) {
@@ -693,14 +694,14 @@ void dumpNewEntityFile(
 
 void dumpActivateEntityFile(
     const std::string& outputFilePath,
-    utils::btc::WeightedQuickUnion& quickUnion,
+    utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const CountList& activateEntityCountList
 ) {
     logger.info(fmt::format("Dump activate entity file to: {}", outputFilePath));
     std::ofstream newEntityFile(outputFilePath.c_str());
 
-    utils::btc::WeightedQuickUnionClusters quickUnionClusters(quickUnion);
+    utils::btc::RankedQuickUnionClusters quickUnionClusters(quickUnion);
     quickUnionClusters.forEach(
         [&newEntityFile, &clusterLabels, &activateEntityCountList](BtcId entityId, BtcId btcSize) -> void {
             if (activateEntityCountList[entityId]) {
@@ -6,6 +6,7 @@
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
 #include "utils/io_utils.h"
+#include "utils/line_loader.h"
 #include "utils/task_utils.h"
 #include "utils/json_utils.h"
 #include "fmt/format.h"
@@ -56,7 +57,7 @@ int main(int argc, char* argv[]) {
 
         // 加载UF File
         std::string quickUnionFilePath = argumentParser.get("--uf_file");
-        utils::btc::WeightedQuickUnion quickUnion(1);
+        utils::btc::RankedQuickUnion quickUnion(1);
         std::set<BtcId> minterTxRootIds;
         logUsedMemory();
         logger.info(fmt::format("Load quick union file: {}", quickUnionFilePath));
@@ -75,26 +76,14 @@ int main(int argc, char* argv[]) {
         // 加载交易所实体（手动收集标签+WalletExplorer）
         std::string exchangeEntityListFilePath = argumentParser.get("--exchange_entity_list_file");
         logger.info(fmt::format("Load exchange entity list file: {}", exchangeEntityListFilePath));
-        const auto& exchangeEntities = utils::readLines<std::set<BtcId>, BtcId>(
-            exchangeEntityListFilePath,
-            [](const std::string& line) -> BtcId {
-                return std::stoi(line);
-            },
-            [](std::set<BtcId>& results, BtcId value) {
-                results.insert(value);
-            }
-        );
+        const auto& exchangeEntityList = utils::loadNumberLines<BtcId>(exchangeEntityListFilePath);
+        const std::set<BtcId> exchangeEntities(exchangeEntityList.cbegin(), exchangeEntityList.cend());
         logger.info(fmt::format("Loaded exchange entity list: {}", exchangeEntities.size()));
 
         // 加载交易所地址（矿工交易+交易频率最高）
         std::string minerTxCombinedListFilePath = argumentParser.get("--miner_tx_combined_list");
         logger.info(fmt::format("Load miner tx combined list file: {}", minerTxCombinedListFilePath));
-        const auto& minerTxCombinedAddresses = utils::readLines<std::vector<BtcId>, BtcId>(
-            minerTxCombinedListFilePath,
-            [](const std::string& line) -> BtcId {
-                return std::stoi(line);
-            }
-        );
+        const auto& minerTxCombinedAddresses = utils::loadNumberLines<BtcId>(minerTxCombinedListFilePath);
         logger.info(fmt::format("Loaded miner tx combined list file: {}", minerTxCombinedAddresses.size()));
 
         // 计算交易所实体（矿工交易+交易频率最高）
@@ -114,7 +103,7 @@ int main(int argc, char* argv[]) {
         // 导出用户列表报告
         std::string outputReportFilePath = argumentParser.get("output_report_file");
         std::ofstream outputReportFile(outputReportFilePath);
-        utils::btc::WeightedQuickUnionClusters quickUnionClusters(quickUnion);
+        utils::btc::RankedQuickUnionClusters quickUnionClusters(quickUnion);
 
         logger.info(fmt::format("Export report file: {}", outputReportFilePath));
         outputReportFile << fmt::format("User,IsMiner,IsLabeldExchange,IsFoundExchange") << std::endl;
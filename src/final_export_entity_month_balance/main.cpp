@@ -5,7 +5,9 @@
 
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
+#include "utils/id_bitset.h"
 #include "utils/io_utils.h"
+#include "utils/line_loader.h"
 #include "utils/task_utils.h"
 #include "utils/json_utils.h"
 #include "fmt/format.h"
@@ -101,16 +103,16 @@ void mergeBalanceList(
     const BalanceList& src
 );
 
-std::set<BtcId> loadExcludeRootAddresses(
+utils::btc::IdBitset loadExcludeRootAddresses(
     const std::string& excludeAddressListFilePath,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 );
 
 BalanceList processYearMonthAddressBalance(
     CountList& entityCountList,
     const BalanceList& balanceList,
-    utils::btc::WeightedQuickUnion& quickUnion,
-    const std::set<BtcId>& exchangeRootAddresseIds
+    utils::btc::RankedQuickUnion& quickUnion,
+    const utils::btc::IdBitset& exchangeRootAddresseIds
 );
 
 void processYearMonthEntityBalance(
@@ -201,7 +203,7 @@ int main(int argc, char* argv[]) {
     try {
         // 读取UnionFind文件
         const std::string ufFilePath = argumentParser.get("--union_file");
-        utils::btc::WeightedQuickUnion quickUnion(1);
+        utils::btc::RankedQuickUnion quickUnion(1);
         logger.info(fmt::format("Load quickUnion from {}", ufFilePath));
         quickUnion.load(ufFilePath);
         logger.info(fmt::format("Loaded quickUnion {} items from {}", quickUnion.getSize(), ufFilePath));
@@ -224,7 +226,7 @@ int main(int argc, char* argv[]) {
 
         // 加载需要排除的实体地址文件
         const std::string excludeAddressListFilePath = argumentParser.get("--exclude_addrs");
-        const std::set<BtcId>& excludeRootAddresses = loadExcludeRootAddresses(excludeAddressListFilePath, quickUnion);
+        const utils::btc::IdBitset& excludeRootAddresses = loadExcludeRootAddresses(excludeAddressListFilePath, quickUnion);
 
         logUsedMemory();
 
@@ -603,19 +605,15 @@ void mergeBalanceList(
     }
 }
 
-std::set<BtcId> loadExcludeRootAddresses(
+utils::btc::IdBitset loadExcludeRootAddresses(
     const std::string& excludeAddressListFilePath,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 ) {
-    std::set<BtcId> excludeRootAddresses;
+    utils::btc::IdBitset excludeRootAddresses(quickUnion.getSize());
 
     if (!excludeAddressListFilePath.empty()) {
         logger.info(fmt::format("Load excludeAddresses: {}", excludeAddressListFilePath));
-        std::vector<BtcId> excludeAddresses = utils::readLines<std::vector<BtcId>, BtcId>(
-            excludeAddressListFilePath,
-            [](const std::string& line) -> BtcId {
-                return std::stoi(line);
-        });
+        std::vector<BtcId> excludeAddresses = utils::loadNumberLines<BtcId>(excludeAddressListFilePath);
         logger.info(fmt::format("Loaded excludeAddresses: {}", excludeAddresses.size()));
 
         for (BtcId addressId : excludeAddresses) {
@@ -629,8 +627,8 @@ std::set<BtcId> loadExcludeRootAddresses(
 BalanceList processYearMonthAddressBalance(
     CountList& entityCountList,
     const BalanceList& balanceList,
-    utils::btc::WeightedQuickUnion& quickUnion,
-    const std::set<BtcId>& exchangeRootAddresseIds
+    utils::btc::RankedQuickUnion& quickUnion,
+    const utils::btc::IdBitset& exchangeRootAddresseIds
 ) {
     using utils::btc::BtcSize;
 
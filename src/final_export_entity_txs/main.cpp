@@ -51,7 +51,7 @@ static argparse::ArgumentParser createArgumentParser();
 void generateEntityTxsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const utils::btc::WeightedQuickUnion* quickUnion,
+    const utils::btc::RankedQuickUnion* quickUnion,
     const std::vector<utils::btc::ClusterLabels>* clusterLabels,
     const TxCountsList* txCountsList,
     std::ostream* outputFile
@@ -60,7 +60,7 @@ void generateEntityTxsOfDays(
 void calculateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::string& dayDir,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const TxCountsList& txCountsList,
     std::ostream& outputFile
@@ -69,7 +69,7 @@ void calculateAddressStatisticsOfDays(
 void calculateAddressStatisticsOfBlock(
     uint32_t workerIndex,
     const json& block,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const TxCountsList& txCountsList,
     std::ostream& outputFile
@@ -78,7 +78,7 @@ void calculateAddressStatisticsOfBlock(
 void calculateAddressStatisticsOfTx(
     uint32_t workerIndex,
     const json& tx,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const TxCountsList& txCountsList,
     std::ostream& outputFile,
@@ -128,7 +128,7 @@ int main(int argc, char* argv[]) {
     logUsedMemory();
 
     const std::string ufFilePath = argumentParser.get("--union_file");
-    utils::btc::WeightedQuickUnion quickUnion(1);
+    utils::btc::RankedQuickUnion quickUnion(1);
     logger.info(fmt::format("Load quickUnion from {}", ufFilePath));
     quickUnion.load(ufFilePath);
     logger.info(fmt::format("Loaded quickUnion {} items from {}", quickUnion.getSize(), ufFilePath));
@@ -251,7 +251,7 @@ groupDaysListByYears(const std::vector<std::string>& daysList, uint32_t startYea
 void generateEntityTxsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    const utils::btc::WeightedQuickUnion* quickUnion,
+    const utils::btc::RankedQuickUnion* quickUnion,
     const std::vector<utils::btc::ClusterLabels>* clusterLabels,
     const TxCountsList* txCountsList,
     std::ostream* outputFile
@@ -274,7 +274,7 @@ void generateEntityTxsOfDays(
 void calculateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::string& dayDir,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const TxCountsList& txCountsList,
     std::ostream& outputFile
@@ -321,7 +321,7 @@ void calculateAddressStatisticsOfDays(
 void calculateAddressStatisticsOfBlock(
     uint32_t workerIndex,
     const json& block,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const TxCountsList& txCountsList,
     std::ostream& outputFile
@@ -384,7 +384,7 @@ public:
 void calculateAddressStatisticsOfTx(
     uint32_t workerIndex,
     const json& tx,
-    const utils::btc::WeightedQuickUnion& quickUnion,
+    const utils::btc::RankedQuickUnion& quickUnion,
     const std::vector<utils::btc::ClusterLabels>& clusterLabels,
     const TxCountsList& txCountsList,
     std::ostream& outputFile,
@@ -51,25 +51,26 @@ static argparse::ArgumentParser createArgumentParser();
 std::unique_ptr<TxCountsList> generateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    utils::btc::WeightedQuickUnion* quickUnion
+    utils::btc::RankedQuickUnion* quickUnion
 );
 
 void calculateAddressStatisticsOfDays(
     const std::string& dayDir,
     TxCountsList* txCountsList,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 );
 
 void calculateAddressStatisticsOfBlock(
     const json& block,
     TxCountsList* txCountsList,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 );
 
-void calculateAddressStatisticsOfTx(
-    const json& tx,
-    TxCountsList* txCountsList,
-    const utils::btc::WeightedQuickUnion& quickUnion
+void collectAddressIdsOfTx(
+    const json& tx,
+    BtcId addressCount,
+    std::vector<BtcId>* inputAddressIds,
+    std::vector<BtcId>* outputAddressIds
 );
 
 void dumpCountList(
@@ -110,7 +111,7 @@ int main(int argc, char* argv[]) {
     logUsedMemory();
 
     const std::string ufFilePath = argumentParser.get("--union_file");
-    utils::btc::WeightedQuickUnion quickUnion(1);
+    utils::btc::RankedQuickUnion quickUnion(1);
     logger.info(fmt::format("Load quickUnion from {}", ufFilePath));
     quickUnion.load(ufFilePath);
     logger.info(fmt::format("Loaded quickUnion {} items from {}", quickUnion.getSize(), ufFilePath));
@@ -217,7 +218,7 @@ groupDaysListByYears(const std::vector<std::string>& daysList, uint32_t startYea
 std::unique_ptr<TxCountsList> generateAddressStatisticsOfDays(
     uint32_t workerIndex,
     const std::vector<std::string>* daysDirList,
-    utils::btc::WeightedQuickUnion* quickUnion
+    utils::btc::RankedQuickUnion* quickUnion
 ) {
     logger.info(fmt::format("Worker started: {}", workerIndex));
     BtcId addressCount = quickUnion->getSize();
@@ -238,7 +239,7 @@ std::unique_ptr<TxCountsList> generateAddressStatisticsOfDays(
 void calculateAddressStatisticsOfDays(
     const std::string& dayDir,
     TxCountsList* txCountsList,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 ) {
     try {
         auto convertedBlocksFilePath = fmt::format("{}/{}", dayDir, "converted-block-list.json");
@@ -279,18 +280,33 @@ void calculateAddressStatisticsOfDays(
 void calculateAddressStatisticsOfBlock(
     const json& block,
     TxCountsList* txCountsList,
-    const utils::btc::WeightedQuickUnion& quickUnion
+    const utils::btc::RankedQuickUnion& quickUnion
 ) {
     std::string blockHash = utils::json::get(block, "hash");
 
     try {
         const auto& txs = block["tx"];
 
+        std::vector<BtcId> inputAddressIds;
+        std::vector<BtcId> outputAddressIds;
         for (const auto& tx : txs) {
-            calculateAddressStatisticsOfTx(
-                tx, txCountsList, quickUnion
+            collectAddressIdsOfTx(
+                tx, quickUnion.getSize(), &inputAddressIds, &outputAddressIds
             );
         }
+
+        // 整个区块的地址一次批量查找根节点，越界的地址在收集时已按交易跳过
+        std::vector<BtcId> inputClusterIds(inputAddressIds.size());
+        quickUnion.findRoots(inputAddressIds, inputClusterIds);
+        for (BtcId clusterId : inputClusterIds) {
+            ++(*txCountsList)[clusterId].first;
+        }
+
+        std::vector<BtcId> outputClusterIds(outputAddressIds.size());
+        quickUnion.findRoots(outputAddressIds, outputClusterIds);
+        for (BtcId clusterId : outputClusterIds) {
+            ++(*txCountsList)[clusterId].second;
+        }
     }
     catch (std::exception& e) {
         logger.error(fmt::format("Error when process block {}", blockHash));
@@ -298,13 +314,17 @@ void calculateAddressStatisticsOfBlock(
     }
 }
 
-void calculateAddressStatisticsOfTx(
-    const json& tx,
-    TxCountsList* txCountsList,
-    const utils::btc::WeightedQuickUnion& quickUnion
+void collectAddressIdsOfTx(
+    const json& tx,
+    BtcId addressCount,
+    std::vector<BtcId>* inputAddressIds,
+    std::vector<BtcId>* outputAddressIds
 ) {
     std::string txHash = utils::json::get(tx, "hash");
 
+    // 交易出错时只丢弃这笔交易的地址
+    std::size_t inputAddressCount = inputAddressIds->size();
+    std::size_t outputAddressCount = outputAddressIds->size();
     try {
         const auto& inputs = utils::json::get(tx, "inputs");
         for (const auto& input : inputs) {
@@ -320,8 +340,10 @@ void calculateAddressStatisticsOfTx(
             }
 
             BtcId addressId = addrItem.value();
-            BtcId clusterId = quickUnion.findRoot(addressId);
-            ++txCountsList->at(clusterId).first;
+            if (addressId >= addressCount) {
+                throw std::out_of_range(fmt::format("Address id {} out of union find size {}", addressId, addressCount));
+            }
+            inputAddressIds->push_back(addressId);
 
             // 只计算第一笔input，因为所有input都是同一个用户的
             break;
@@ -333,14 +355,19 @@ void calculateAddressStatisticsOfTx(
             if (addrItem == output.cend()) {
                 continue;
             }
-            BtcId addressId = addrItem.value();
-            BtcId clusterId = quickUnion.findRoot(addressId);
-            ++txCountsList->at(clusterId).second;
+            BtcId addressId = addrItem.value();
+            if (addressId >= addressCount) {
+                throw std::out_of_range(fmt::format("Address id {} out of union find size {}", addressId, addressCount));
+            }
+            outputAddressIds->push_back(addressId);
         }
     }
     catch (std::exception& e) {
         logger.error(fmt::format("Error when process tx {}", txHash));
         logger.error(e.what());
+
+        inputAddressIds->resize(inputAddressCount);
+        outputAddressIds->resize(outputAddressCount);
     }
 }
 
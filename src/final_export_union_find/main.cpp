@@ -1,6 +1,7 @@
 #include "btc-config.h"
 #include "final_export_union_find/logger.h"
 
+#include "utils/id2address.h"
 #include "utils/io_utils.h"
 #include "utils/mem_utils.h"
 #include "utils/union_find.h"
@@ -31,16 +32,16 @@ int main(int argc, char* argv[]) {
 
     try {
         std::string id2AddressFilePath = argumentParser.get("id2addr");
-        logger.info("Load address2Id...");
-        const auto& address2Id = utils::btc::loadId2Address(id2AddressFilePath.c_str());
-        logger.info(fmt::format("Loaded address2Id: {} items", address2Id.size()));
+        logger.info("Map id2Address...");
+        utils::btc::Id2AddressView id2Address(id2AddressFilePath);
+        logger.info(fmt::format("Mapped id2Address: {} items", id2Address.size()));
 
         logUsedMemory();
 
         std::string quickUnionFilePath = argumentParser.get("--uf_file");
         logger.info(fmt::format("Load union find form {}", quickUnionFilePath));
 
-        utils::btc::WeightedQuickUnion quickUnion(1);
+        utils::btc::RankedQuickUnion quickUnion(1);
         quickUnion.load(quickUnionFilePath);
 
         logger.info(fmt::format("Loaded ids: {}", quickUnion.getSize()));
@@ -52,9 +53,10 @@ int main(int argc, char* argv[]) {
         std::ofstream outputFile(outputFilePath.c_str());
         logger.info(fmt::format("Dump union find result to: {}", outputFilePath));
 
-        BtcId addressId = 0;
+        BtcId addressCount = id2Address.size();
         std::string lines;
-        for (const std::string address : address2Id) {
+        for (BtcId addressId = 0; addressId != addressCount; ++addressId) {
+            auto address = id2Address[addressId];
             auto rootAddressId = quickUnion.findRoot(addressId);
             std::string line = fmt::format("{},{}\n", rootAddressId, address);
             lines.append(line);
@@ -63,8 +65,6 @@ int main(int argc, char* argv[]) {
                 outputFile << lines;
                 lines.clear();
             }
-
-            ++addressId;
         }
 
         if (!lines.empty()) {
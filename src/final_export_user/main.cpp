@@ -35,7 +35,7 @@ static argparse::ArgumentParser createArgumentParser();
 std::set<BtcId> parseMinerAddressIds(const std::string& minerTxJsonFilePath);
 std::vector<BalanceListPtr> loadBtcBalances(
     const fs::path& entityBalanceDirPath,
-    utils::btc::WeightedQuickUnion& quickUnion
+    utils::btc::RankedQuickUnion& quickUnion
 );
 std::size_t loadBalanceList(
     const std::string& inputFilePath,
@@ -69,7 +69,7 @@ int main(int argc, char* argv[]) {
 
         // 加载UF File
         std::string quickUnionFilePath = argumentParser.get("--uf_file");
-        utils::btc::WeightedQuickUnion quickUnion(1);
+        utils::btc::RankedQuickUnion quickUnion(1);
         std::set<BtcId> minterTxRootIds;
         logUsedMemory();
         logger.info(fmt::format("Load quick union file: {}", quickUnionFilePath));
@@ -139,7 +139,7 @@ int main(int argc, char* argv[]) {
         // 导出用户列表报告
         std::string outputReportFilePath = argumentParser.get("output_report_file");
         std::ofstream outputReportFile(outputReportFilePath);
-        utils::btc::WeightedQuickUnionClusters quickUnionClusters(quickUnion);
+        utils::btc::RankedQuickUnionClusters quickUnionClusters(quickUnion);
 
         logger.info(fmt::format("Export report file: {}", outputReportFilePath));
         outputReportFile << "User,AddressCount,EntityYear,IsMiner,IsLabeldExchange,IsFoundExchange";
@@ -297,7 +297,7 @@ std::size_t loadYearList(
 
 std::vector<BalanceListPtr> loadBtcBalances(
     const fs::path& entityBalanceDirPath,
-    utils::btc::WeightedQuickUnion& quickUnion
+    utils::btc::RankedQuickUnion& quickUnion
 ) {
     std::vector<BalanceListPtr> btcBalances;
 
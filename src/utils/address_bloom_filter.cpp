@@ -0,0 +1,200 @@
+#include "utils/address_bloom_filter.h"
+#include "utils/id2address.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace utils::btc {
+    struct AddressBloomFilterFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t keyCount;
+        uint64_t blockCount;
+        // Version 2 on
+        uint64_t checksum;
+        uint64_t sourceFileSize;
+        int64_t sourceModifiedTime;
+    };
+
+    // Version 1 headers end after blockCount
+    static const std::size_t BLOOM_FILTER_FILE_HEADER_V1_SIZE = offsetof(AddressBloomFilterFileHeader, checksum);
+
+    static const char BLOOM_FILTER_FILE_MAGIC[8] = { 'B', 'T', 'C', 'B', 'L', 'O', 'O', 'M' };
+    static const uint32_t BLOOM_FILTER_FILE_VERSION = 2;
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    static int64_t getModifiedTime(const std::string& filePath) {
+        return std::filesystem::last_write_time(filePath).time_since_epoch().count();
+    }
+
+    static uint64_t updateChecksum(uint64_t checksum, std::string_view address) {
+        return (checksum ^ hashAddressFnv1a(address)) * 0x100000001b3ULL;
+    }
+
+    // FNV-1a leaves the high bits poorly mixed for short keys, so both halves go through a finalizer
+    static uint64_t mixHash(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    AddressBloomFilter::AddressBloomFilter(uint64_t expectedKeyCount, uint32_t bitsPerKey) :
+        _blocks(std::max<uint64_t>(expectedKeyCount * bitsPerKey / 512, 1), Block {}),
+        _version(BLOOM_FILTER_FILE_VERSION),
+        _keyCount(0),
+        _checksum(0),
+        _sourceFileSize(0),
+        _sourceModifiedTime(0) {
+    }
+
+    void AddressBloomFilter::insert(std::string_view address) {
+        uint64_t hash = hashAddressFnv1a(address);
+        auto& block = _blocks[(mixHash(hash) >> 32) % _blocks.size()];
+
+        uint64_t bitIndexes = mixHash(hash + 0x9e3779b97f4a7c15ULL);
+        for (uint32_t wordIndex = 0; wordIndex != 8; ++wordIndex) {
+            block.words[wordIndex] |= 1ULL << ((bitIndexes >> (wordIndex * 6)) & 63);
+        }
+
+        ++_keyCount;
+        _checksum = updateChecksum(_checksum, address);
+    }
+
+    bool AddressBloomFilter::mayContain(std::string_view address) const {
+        uint64_t hash = hashAddressFnv1a(address);
+        const auto& block = _blocks[(mixHash(hash) >> 32) % _blocks.size()];
+
+        // The 8 words are in the cache line read anyway, testing all of them costs less than a branch each
+        uint64_t bitIndexes = mixHash(hash + 0x9e3779b97f4a7c15ULL);
+        uint64_t missingBits = 0;
+        for (uint32_t wordIndex = 0; wordIndex != 8; ++wordIndex) {
+            missingBits |= ~block.words[wordIndex] & (1ULL << ((bitIndexes >> (wordIndex * 6)) & 63));
+        }
+
+        return missingBits == 0;
+    }
+
+    void AddressBloomFilter::saveOf(const std::string& id2AddressFilePath) const {
+        AddressBloomFilterFileHeader header = {};
+        std::copy(std::begin(BLOOM_FILTER_FILE_MAGIC), std::end(BLOOM_FILTER_FILE_MAGIC), header.magic);
+        header.version = BLOOM_FILTER_FILE_VERSION;
+        header.byteOrderMark = BYTE_ORDER_MARK;
+        header.keyCount = _keyCount;
+        header.blockCount = _blocks.size();
+        header.checksum = _checksum;
+        header.sourceFileSize = std::filesystem::file_size(id2AddressFilePath);
+        header.sourceModifiedTime = getModifiedTime(id2AddressFilePath);
+
+        std::string filePath = getFilePath(id2AddressFilePath);
+
+        std::ofstream outputFile(filePath, std::ios::binary);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outputFile.write(reinterpret_cast<const char*>(_blocks.data()), _blocks.size() * sizeof(Block));
+
+        if (!outputFile) {
+            throw std::runtime_error(fmt::format("Can't write file {}", filePath));
+        }
+    }
+
+    AddressBloomFilter AddressBloomFilter::load(const std::string& filePath) {
+        std::ifstream inputFile(filePath, std::ios::binary);
+        if (!inputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        AddressBloomFilterFileHeader header = {};
+        if (!inputFile.read(reinterpret_cast<char*>(&header), BLOOM_FILTER_FILE_HEADER_V1_SIZE) ||
+            !std::equal(std::begin(BLOOM_FILTER_FILE_MAGIC), std::end(BLOOM_FILTER_FILE_MAGIC), header.magic)) {
+            throw std::runtime_error(fmt::format("Not a bloom filter file: {}", filePath));
+        }
+
+        if (header.byteOrderMark != BYTE_ORDER_MARK) {
+            throw std::runtime_error(fmt::format("Bloom filter file {} is written in another byte order", filePath));
+        }
+
+        if (header.version > BLOOM_FILTER_FILE_VERSION) {
+            throw std::runtime_error(fmt::format(
+                "Bloom filter file {} has unsupported version {}", filePath, header.version
+            ));
+        }
+
+        if (header.version >= 2 && !inputFile.read(
+            reinterpret_cast<char*>(&header) + BLOOM_FILTER_FILE_HEADER_V1_SIZE,
+            sizeof(header) - BLOOM_FILTER_FILE_HEADER_V1_SIZE
+        )) {
+            throw std::runtime_error(fmt::format("Bloom filter file {} is truncated", filePath));
+        }
+
+        if (!header.blockCount) {
+            throw std::runtime_error(fmt::format("Bloom filter file {} has no blocks", filePath));
+        }
+
+        AddressBloomFilter filter;
+        filter._version = header.version;
+        filter._keyCount = header.keyCount;
+        filter._checksum = header.checksum;
+        filter._sourceFileSize = header.sourceFileSize;
+        filter._sourceModifiedTime = header.sourceModifiedTime;
+        filter._blocks.resize(header.blockCount);
+        if (!inputFile.read(reinterpret_cast<char*>(filter._blocks.data()), header.blockCount * sizeof(Block))) {
+            throw std::runtime_error(fmt::format("Bloom filter file {} is truncated", filePath));
+        }
+
+        return filter;
+    }
+
+    std::string AddressBloomFilter::getFilePath(const std::string& id2AddressFilePath) {
+        return id2AddressFilePath + ".bloom";
+    }
+
+    std::unique_ptr<AddressBloomFilter> AddressBloomFilter::loadOf(
+        const std::string& id2AddressFilePath,
+        uint64_t addressCount
+    ) {
+        std::string filePath = getFilePath(id2AddressFilePath);
+        if (!std::filesystem::exists(filePath)) {
+            return nullptr;
+        }
+
+        auto filter = std::make_unique<AddressBloomFilter>(load(filePath));
+        if (!filter->matches(id2AddressFilePath, addressCount)) {
+            return nullptr;
+        }
+
+        return filter;
+    }
+
+    bool AddressBloomFilter::matches(const std::string& id2AddressFilePath, uint64_t addressCount) const {
+        if (_version < 2 || _keyCount != addressCount ||
+            _sourceFileSize != std::filesystem::file_size(id2AddressFilePath)) {
+            return false;
+        }
+
+        if (_sourceModifiedTime == getModifiedTime(id2AddressFilePath)) {
+            return true;
+        }
+
+        // A copied or rewritten id2addr of the same size may still hold the same addresses
+        Id2AddressView id2Address(id2AddressFilePath);
+        uint64_t checksum = 0;
+        for (BtcId addressId = 0; addressId != id2Address.size(); ++addressId) {
+            checksum = updateChecksum(checksum, id2Address.getAddress(addressId));
+        }
+
+        return checksum == _checksum;
+    }
+}
@@ -0,0 +1,383 @@
+#include "utils/address_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+namespace utils::btc {
+    static const char BASE58_ALPHABET[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    static const char BECH32_CHARSET[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+    static const std::string_view BECH32_PREFIX = "bc1";
+    static const uint32_t BECH32_CONSTANT = 1;
+    static const uint32_t BECH32M_CONSTANT = 0x2bc830a3;
+    static const std::size_t BECH32_CHECKSUM_LENGTH = 6;
+
+    // Version byte, 20 bytes hash and 4 bytes checksum
+    static const std::size_t BASE58_DATA_SIZE = 25;
+    static const uint8_t P2PKH_VERSION = 0x00;
+    static const uint8_t P2SH_VERSION = 0x05;
+
+    static const std::size_t ADDRESS_SET_INITIAL_SLOT_COUNT = 1024;
+    // An unordered_set node: the std::string, the next pointer and the cached hash. The string buffer
+    // is added per address from its capacity.
+    static const std::size_t FALLBACK_NODE_BYTES = sizeof(std::string) + 2 * sizeof(void*);
+    // Longest encodings: base58 addresses, P2WPKH and 32 bytes witness programs
+    static const std::size_t BASE58_ADDRESS_MAX_LENGTH = 34;
+    static const std::size_t P2WPKH_ADDRESS_LENGTH = 42;
+    static const std::size_t P2WSH_ADDRESS_LENGTH = 62;
+
+    static int8_t getBase58Digit(char c) {
+        static const auto digits = [] {
+            std::array<int8_t, 256> digits;
+            digits.fill(-1);
+            for (int8_t digit = 0; digit != 58; ++digit) {
+                digits[static_cast<uint8_t>(BASE58_ALPHABET[digit])] = digit;
+            }
+
+            return digits;
+        }();
+
+        return digits[static_cast<uint8_t>(c)];
+    }
+
+    static int8_t getBech32Value(char c) {
+        static const auto values = [] {
+            std::array<int8_t, 256> values;
+            values.fill(-1);
+            for (int8_t value = 0; value != 32; ++value) {
+                values[static_cast<uint8_t>(BECH32_CHARSET[value])] = value;
+            }
+
+            return values;
+        }();
+
+        return values[static_cast<uint8_t>(c)];
+    }
+
+    static uint32_t bech32Polymod(const uint8_t* values, std::size_t count) {
+        static const uint32_t GENERATORS[] = { 0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3 };
+
+        // Expanded "bc" prefix
+        static const uint8_t PREFIX_VALUES[] = { 3, 3, 0, 2, 3 };
+
+        uint32_t checksum = 1;
+        auto update = [&checksum](uint8_t value) {
+            uint8_t top = checksum >> 25;
+            checksum = ((checksum & 0x1ffffff) << 5) ^ value;
+            for (int bit = 0; bit != 5; ++bit) {
+                if ((top >> bit) & 1) {
+                    checksum ^= GENERATORS[bit];
+                }
+            }
+        };
+
+        for (uint8_t value : PREFIX_VALUES) {
+            update(value);
+        }
+        for (std::size_t valueIndex = 0; valueIndex != count; ++valueIndex) {
+            update(values[valueIndex]);
+        }
+
+        return checksum;
+    }
+
+    static bool decodeBase58Address(std::string_view address, AddressKey& key) {
+        uint8_t data[BASE58_DATA_SIZE] = {};
+        for (char c : address) {
+            int8_t digit = getBase58Digit(c);
+            if (digit < 0) {
+                return false;
+            }
+
+            uint32_t carry = digit;
+            for (auto byteIt = std::rbegin(data); byteIt != std::rend(data); ++byteIt) {
+                carry += uint32_t(*byteIt) * 58;
+                *byteIt = static_cast<uint8_t>(carry);
+                carry >>= 8;
+            }
+
+            if (carry) {
+                return false;
+            }
+        }
+
+        // Canonical strings have one leading '1' per leading zero byte
+        std::size_t leadingOnes = std::find_if(address.cbegin(), address.cend(), [](char c) {
+            return c != '1';
+        }) - address.cbegin();
+        std::size_t leadingZeros = std::find_if(std::cbegin(data), std::cend(data), [](uint8_t byte) {
+            return byte != 0;
+        }) - std::cbegin(data);
+        if (leadingOnes != leadingZeros) {
+            return false;
+        }
+
+        if (data[0] == P2PKH_VERSION) {
+            key.type = AddressType::P2PKH;
+        }
+        else if (data[0] == P2SH_VERSION) {
+            key.type = AddressType::P2SH;
+        }
+        else {
+            return false;
+        }
+
+        std::fill(std::begin(key.payload), std::end(key.payload), 0);
+        std::copy(data + 1, data + BASE58_DATA_SIZE, key.payload);
+
+        return true;
+    }
+
+    static std::string encodeBase58Address(const AddressKey& key) {
+        uint8_t data[BASE58_DATA_SIZE];
+        data[0] = key.type == AddressType::P2PKH ? P2PKH_VERSION : P2SH_VERSION;
+        std::copy(key.payload, key.payload + BASE58_DATA_SIZE - 1, data + 1);
+
+        // 25 bytes take at most 35 digits
+        uint8_t digits[35] = {};
+        std::size_t digitCount = 0;
+        for (uint8_t byte : data) {
+            uint32_t carry = byte;
+            for (std::size_t digitIndex = 0; digitIndex != digitCount; ++digitIndex) {
+                carry += uint32_t(digits[digitIndex]) << 8;
+                digits[digitIndex] = carry % 58;
+                carry /= 58;
+            }
+            while (carry) {
+                digits[digitCount++] = carry % 58;
+                carry /= 58;
+            }
+        }
+
+        std::string address;
+        for (std::size_t byteIndex = 0; byteIndex != BASE58_DATA_SIZE && !data[byteIndex]; ++byteIndex) {
+            address.push_back('1');
+        }
+        for (std::size_t digitIndex = digitCount; digitIndex != 0; --digitIndex) {
+            address.push_back(BASE58_ALPHABET[digits[digitIndex - 1]]);
+        }
+
+        return address;
+    }
+
+    static bool decodeBech32Address(std::string_view address, AddressKey& key) {
+        // Version, at most 52 values of a 32 bytes program and the checksum
+        uint8_t values[1 + 52 + BECH32_CHECKSUM_LENGTH];
+        std::size_t valueCount = address.size() - BECH32_PREFIX.size();
+        if (valueCount > std::size(values) || valueCount < 1 + BECH32_CHECKSUM_LENGTH) {
+            return false;
+        }
+
+        for (std::size_t valueIndex = 0; valueIndex != valueCount; ++valueIndex) {
+            int8_t value = getBech32Value(address[BECH32_PREFIX.size() + valueIndex]);
+            if (value < 0) {
+                return false;
+            }
+
+            values[valueIndex] = value;
+        }
+
+        uint8_t version = values[0];
+        uint32_t constant = version ? BECH32M_CONSTANT : BECH32_CONSTANT;
+        if (bech32Polymod(values, valueCount) != constant) {
+            return false;
+        }
+
+        // 5 bits groups to bytes, padding must be short and zero
+        uint8_t program[AddressKey::PAYLOAD_SIZE];
+        std::size_t programSize = 0;
+        uint32_t bits = 0;
+        uint32_t bitCount = 0;
+        for (std::size_t valueIndex = 1; valueIndex != valueCount - BECH32_CHECKSUM_LENGTH; ++valueIndex) {
+            bits = (bits << 5) | values[valueIndex];
+            bitCount += 5;
+            if (bitCount >= 8) {
+                bitCount -= 8;
+                if (programSize == std::size(program)) {
+                    return false;
+                }
+                program[programSize++] = static_cast<uint8_t>(bits >> bitCount);
+            }
+        }
+        if (bitCount >= 5 || (bits & ((1u << bitCount) - 1))) {
+            return false;
+        }
+
+        if (version == 0 && programSize == 20) {
+            key.type = AddressType::P2WPKH;
+        }
+        else if (version == 0 && programSize == 32) {
+            key.type = AddressType::P2WSH;
+        }
+        else if (version == 1 && programSize == 32) {
+            key.type = AddressType::P2TR;
+        }
+        else {
+            return false;
+        }
+
+        std::fill(std::begin(key.payload), std::end(key.payload), 0);
+        std::copy(program, program + programSize, key.payload);
+
+        return true;
+    }
+
+    static std::string encodeBech32Address(const AddressKey& key) {
+        std::size_t programSize = key.type == AddressType::P2WPKH ? 20 : 32;
+
+        uint8_t values[1 + 52 + BECH32_CHECKSUM_LENGTH];
+        std::size_t valueCount = 0;
+        values[valueCount++] = key.type == AddressType::P2TR ? 1 : 0;
+
+        uint32_t bits = 0;
+        uint32_t bitCount = 0;
+        for (std::size_t byteIndex = 0; byteIndex != programSize; ++byteIndex) {
+            bits = (bits << 8) | key.payload[byteIndex];
+            bitCount += 8;
+            while (bitCount >= 5) {
+                bitCount -= 5;
+                values[valueCount++] = (bits >> bitCount) & 0x1f;
+            }
+        }
+        if (bitCount) {
+            values[valueCount++] = (bits << (5 - bitCount)) & 0x1f;
+        }
+
+        std::fill(values + valueCount, values + valueCount + BECH32_CHECKSUM_LENGTH, 0);
+        uint32_t constant = values[0] ? BECH32M_CONSTANT : BECH32_CONSTANT;
+        uint32_t checksum = bech32Polymod(values, valueCount + BECH32_CHECKSUM_LENGTH) ^ constant;
+        for (std::size_t checksumIndex = 0; checksumIndex != BECH32_CHECKSUM_LENGTH; ++checksumIndex) {
+            values[valueCount++] = (checksum >> (5 * (BECH32_CHECKSUM_LENGTH - 1 - checksumIndex))) & 0x1f;
+        }
+
+        std::string address(BECH32_PREFIX);
+        for (std::size_t valueIndex = 0; valueIndex != valueCount; ++valueIndex) {
+            address.push_back(BECH32_CHARSET[values[valueIndex]]);
+        }
+
+        return address;
+    }
+
+    bool decodeAddress(std::string_view address, AddressKey& key) {
+        if (address.starts_with(BECH32_PREFIX)) {
+            return decodeBech32Address(address, key);
+        }
+        else if (address.starts_with('1') || address.starts_with('3')) {
+            return decodeBase58Address(address, key);
+        }
+
+        return false;
+    }
+
+    std::string encodeAddress(const AddressKey& key) {
+        if (key.type == AddressType::P2PKH || key.type == AddressType::P2SH) {
+            return encodeBase58Address(key);
+        }
+
+        return encodeBech32Address(key);
+    }
+
+    static bool isEmptySlot(const AddressKey& key) {
+        return key.type == AddressType{};
+    }
+
+    AddressSet::AddressSet() : _slots(ADDRESS_SET_INITIAL_SLOT_COUNT), _keyCount(0), _othersBytes(0) {
+    }
+
+    void AddressSet::insert(std::string_view address) {
+        AddressKey key;
+        if (!decodeAddress(address, key)) {
+            auto [addressIt, inserted] = _others.emplace(address);
+            if (inserted) {
+                _othersBytes += FALLBACK_NODE_BYTES + addressIt->capacity() + 1;
+            }
+
+            return;
+        }
+
+        std::size_t slotMask = _slots.size() - 1;
+        std::size_t slotIndex = AddressKeyHash()(key) & slotMask;
+        while (!isEmptySlot(_slots[slotIndex])) {
+            if (_slots[slotIndex] == key) {
+                return;
+            }
+
+            slotIndex = (slotIndex + 1) & slotMask;
+        }
+
+        _slots[slotIndex] = key;
+        ++_keyCount;
+
+        // Keys are large, so the table may get 3/4 full before growing
+        if (_keyCount * 4 > _slots.size() * 3) {
+            rehash(_slots.size() * 2);
+        }
+    }
+
+    void AddressSet::rehash(std::size_t slotCount) {
+        std::vector<AddressKey> slots(slotCount);
+        std::size_t slotMask = slotCount - 1;
+        for (const auto& key : _slots) {
+            if (isEmptySlot(key)) {
+                continue;
+            }
+
+            std::size_t slotIndex = AddressKeyHash()(key) & slotMask;
+            while (!isEmptySlot(slots[slotIndex])) {
+                slotIndex = (slotIndex + 1) & slotMask;
+            }
+            slots[slotIndex] = key;
+        }
+
+        _slots = std::move(slots);
+    }
+
+    std::size_t AddressSet::getMemoryUsage() const {
+        std::size_t tableBytes = _slots.capacity() * sizeof(AddressKey);
+        if ((_keyCount + 1) * 4 > _slots.size() * 3) {
+            tableBytes *= 3;
+        }
+
+        return tableBytes + _others.bucket_count() * sizeof(void*) + _othersBytes;
+    }
+
+    utils::PackedLines AddressSet::extractPackedSortedAddresses() {
+        // Keys don't sort like their strings, so every key is encoded once. Sized by the longest encoding
+        // of each type, the packed string never grows into a second copy.
+        std::size_t addressBytes = 0;
+        for (const auto& key : _slots) {
+            if (key.type == AddressType::P2PKH || key.type == AddressType::P2SH) {
+                addressBytes += BASE58_ADDRESS_MAX_LENGTH;
+            }
+            else if (key.type == AddressType::P2WPKH) {
+                addressBytes += P2WPKH_ADDRESS_LENGTH;
+            }
+            else if (!isEmptySlot(key)) {
+                addressBytes += P2WSH_ADDRESS_LENGTH;
+            }
+        }
+        for (const auto& address : _others) {
+            addressBytes += address.size();
+        }
+
+        utils::PackedLines addresses;
+        addresses.reserve(size(), addressBytes);
+        for (const auto& key : _slots) {
+            if (!isEmptySlot(key)) {
+                addresses.push_back(encodeAddress(key));
+            }
+        }
+        for (const auto& address : _others) {
+            addresses.push_back(address);
+        }
+
+        _slots = std::vector<AddressKey>(ADDRESS_SET_INITIAL_SLOT_COUNT);
+        _keyCount = 0;
+        _others = std::unordered_set<std::string>();
+        _othersBytes = 0;
+
+        addresses.sort();
+
+        return addresses;
+    }
+}
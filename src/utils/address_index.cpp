@@ -0,0 +1,148 @@
+#include "utils/address_index.h"
+#include "utils/mmap_utils.h"
+#include "utils/io_utils.h"
+#include "fmt/format.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+namespace utils::btc {
+    static const std::size_t INITIAL_SLOT_COUNT = 1024;
+
+    static std::size_t hashAddress(std::string_view address) {
+        return std::hash<std::string_view>()(address);
+    }
+
+    // Smallest power of 2 keeping the table at most half full
+    static std::size_t getSlotCount(std::size_t addressCount) {
+        std::size_t slotCount = INITIAL_SLOT_COUNT;
+        while (slotCount < addressCount * 2) {
+            slotCount *= 2;
+        }
+
+        return slotCount;
+    }
+
+    AddressIndex::AddressIndex() : _offsets(1, 0), _slots(INITIAL_SLOT_COUNT, NO_ID) {
+    }
+
+    AddressIndex AddressIndex::load(const std::string& id2AddressFilePath) {
+        // Same as loadId2Address, a missing file is an empty id2addr
+        if (!std::filesystem::exists(id2AddressFilePath)) {
+            std::cerr << "Id2Address file not found" << std::endl;
+
+            return AddressIndex();
+        }
+
+        utils::mmap::MappedFile id2AddressFile(id2AddressFilePath);
+        const char* data = id2AddressFile.data();
+        const char* dataEnd = data + id2AddressFile.size();
+
+        // Addresses are about 34 bytes, so this is close enough to avoid most rehashes
+        AddressIndex addressIndex;
+        addressIndex.reserve(id2AddressFile.size() / 35, id2AddressFile.size());
+
+        while (data != dataEnd) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', dataEnd - data));
+            if (!lineEnd) {
+                lineEnd = dataEnd;
+            }
+
+            if (lineEnd == data) {
+                break;
+            }
+
+            // A duplicated line would shift the ids of every following line
+            BtcId lineId = addressIndex.size();
+            std::string_view address(data, lineEnd - data);
+            BtcId addressId = addressIndex.insert(address);
+            if (addressId != lineId) {
+                throw std::runtime_error(fmt::format(
+                    "Duplicated address {} at line {} of {}, first seen at line {}",
+                    address, lineId + 1, id2AddressFilePath, addressId + 1
+                ));
+            }
+
+            data = lineEnd == dataEnd ? dataEnd : lineEnd + 1;
+        }
+
+        return addressIndex;
+    }
+
+    BtcId AddressIndex::find(std::string_view address) const {
+        return _slots[findSlot(address)];
+    }
+
+    BtcId AddressIndex::insert(std::string_view address) {
+        std::size_t slotIndex = findSlot(address);
+        if (_slots[slotIndex] != NO_ID) {
+            return _slots[slotIndex];
+        }
+
+        BtcId addressId = size();
+        _arena.append(address);
+        _offsets.push_back(_arena.size());
+        _slots[slotIndex] = addressId;
+
+        if (size() * 2 > _slots.size()) {
+            rehash(_slots.size() * 2);
+        }
+
+        return addressId;
+    }
+
+    void AddressIndex::reserve(Size addressCount, std::size_t addressBytes) {
+        _arena.reserve(addressBytes);
+        _offsets.reserve(addressCount + 1);
+
+        std::size_t slotCount = getSlotCount(addressCount);
+        if (slotCount > _slots.size()) {
+            rehash(slotCount);
+        }
+    }
+
+    void AddressIndex::appendToFile(const std::string& id2AddressFilePath, BtcId firstId) const {
+        std::ofstream id2AddressFile = utils::openLinesForAppend(id2AddressFilePath, firstId);
+
+        std::string buffer;
+        for (BtcId addressId = firstId; addressId < size(); ++addressId) {
+            buffer.append(getAddress(addressId));
+            buffer.push_back('\n');
+        }
+        id2AddressFile.write(buffer.data(), buffer.size());
+
+        if (!id2AddressFile) {
+            throw std::runtime_error(fmt::format("Can't write file {}", id2AddressFilePath));
+        }
+    }
+
+    std::size_t AddressIndex::findSlot(std::string_view address) const {
+        std::size_t slotMask = _slots.size() - 1;
+
+        // Linear probing until the address or an empty slot
+        for (std::size_t slotIndex = hashAddress(address) & slotMask; ; slotIndex = (slotIndex + 1) & slotMask) {
+            BtcId addressId = _slots[slotIndex];
+            if (addressId == NO_ID || getAddress(addressId) == address) {
+                return slotIndex;
+            }
+        }
+    }
+
+    void AddressIndex::rehash(std::size_t slotCount) {
+        _slots.assign(slotCount, NO_ID);
+
+        std::size_t slotMask = slotCount - 1;
+        for (BtcId addressId = 0; addressId != size(); ++addressId) {
+            std::size_t slotIndex = hashAddress(getAddress(addressId)) & slotMask;
+            while (_slots[slotIndex] != NO_ID) {
+                slotIndex = (slotIndex + 1) & slotMask;
+            }
+
+            _slots[slotIndex] = addressId;
+        }
+    }
+}
@@ -56,7 +56,8 @@ namespace utils::btc {
         }
     }
 
-    void dumpId2Address(const char* filePath, const std::set<std::string>& id2Address) {
+    template <typename AddressContainer>
+    static void dumpAddressLines(const char* filePath, const AddressContainer& id2Address) {
         std::cout << fmt::format("Dump i2daddr: {}", filePath) << std::endl;
 
         std::ofstream id2AddressFile(filePath);
@@ -89,6 +90,14 @@ namespace utils::btc {
         }
     }
 
+    void dumpId2Address(const char* filePath, const std::set<std::string>& id2Address) {
+        dumpAddressLines(filePath, id2Address);
+    }
+
+    void dumpId2Address(const char* filePath, const std::vector<std::string>& id2Address) {
+        dumpAddressLines(filePath, id2Address);
+    }
+
     std::map<std::string, BtcId> generateAddress2Id(const std::vector<std::string>& id2Address) {
         std::map<std::string, BtcId> address2Id;
 
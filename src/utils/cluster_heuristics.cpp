@@ -0,0 +1,250 @@
+#include "utils/cluster_heuristics.h"
+#include "utils/json_utils.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace utils::btc {
+    // Payments are usually round in 0.001 BTC, change is whatever is left
+    static const uint64_t ROUND_VALUE_UNIT = 100000;
+    // Mixing txs pay the same value to at least this many outputs
+    static const std::size_t COINJOIN_MIN_EQUAL_OUTPUTS = 3;
+
+    ClusterHeuristic::ClusterHeuristic(std::string name, std::vector<std::string> counterNames) :
+        _name(std::move(name)),
+        _counterNames(std::move(counterNames)),
+        _counters(std::make_unique<std::atomic<uint64_t>[]>(_counterNames.size())) {
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> ClusterHeuristic::getCounters() const {
+        std::vector<std::pair<std::string, uint64_t>> counters;
+        for (std::size_t counterIndex = 0; counterIndex != _counterNames.size(); ++counterIndex) {
+            counters.push_back(std::make_pair(
+                _counterNames[counterIndex], _counters[counterIndex].load(std::memory_order_relaxed)
+            ));
+        }
+
+        return counters;
+    }
+
+    // All inputs of a tx are spent by one entity
+    class MultiInputHeuristic : public ClusterHeuristic {
+    public:
+        MultiInputHeuristic() : ClusterHeuristic("multi_input", { "txs", "edges" }) {
+        }
+
+        bool apply(const HeuristicTx& tx, const EdgeFunc& addEdge) const override {
+            if (tx.inputIds.size() <= 1) {
+                return true;
+            }
+
+            auto firstId = tx.inputIds[0];
+            for (auto inputIt = tx.inputIds.cbegin() + 1; inputIt != tx.inputIds.cend(); ++inputIt) {
+                addEdge(firstId, *inputIt);
+            }
+
+            count(0);
+            count(1, tx.inputIds.size() - 1);
+
+            return true;
+        }
+    };
+
+    // Of two outputs, the one with a round value is the payment and the other one is change
+    class RoundChangeHeuristic : public ClusterHeuristic {
+    public:
+        RoundChangeHeuristic() : ClusterHeuristic("round_change", { "txs", "ambiguous_txs" }) {
+        }
+
+        bool apply(const HeuristicTx& tx, const EdgeFunc& addEdge) const override {
+            if (tx.inputIds.empty() || tx.outputs.size() != 2) {
+                return true;
+            }
+
+            const auto& firstOutput = tx.outputs[0];
+            const auto& secondOutput = tx.outputs[1];
+            if (firstOutput.addressId == NO_ADDRESS_ID || secondOutput.addressId == NO_ADDRESS_ID ||
+                firstOutput.addressId == secondOutput.addressId) {
+                return true;
+            }
+
+            // Paying back to an input address already shows the change
+            if (std::binary_search(tx.inputIds.cbegin(), tx.inputIds.cend(), firstOutput.addressId) ||
+                std::binary_search(tx.inputIds.cbegin(), tx.inputIds.cend(), secondOutput.addressId)) {
+                return true;
+            }
+
+            bool firstRound = isRoundValue(firstOutput.value);
+            bool secondRound = isRoundValue(secondOutput.value);
+            if (firstRound == secondRound) {
+                count(1);
+
+                return true;
+            }
+
+            const auto& changeOutput = firstRound ? secondOutput : firstOutput;
+            addEdge(tx.inputIds[0], changeOutput.addressId);
+            count(0);
+
+            return true;
+        }
+
+    private:
+        static bool isRoundValue(uint64_t value) {
+            return value && value % ROUND_VALUE_UNIT == 0;
+        }
+    };
+
+    // Inputs of CoinJoin like txs belong to many entities, so later heuristics skip them
+    class CoinJoinHeuristic : public ClusterHeuristic {
+    public:
+        CoinJoinHeuristic() : ClusterHeuristic("coinjoin", { "excluded_txs" }) {
+        }
+
+        bool apply(const HeuristicTx& tx, const EdgeFunc&) const override {
+            if (tx.inputIds.size() < COINJOIN_MIN_EQUAL_OUTPUTS || tx.outputs.size() < COINJOIN_MIN_EQUAL_OUTPUTS) {
+                return true;
+            }
+
+            std::unordered_map<uint64_t, std::size_t> valueCounts;
+            std::size_t maxEqualCount = 0;
+            for (const auto& output : tx.outputs) {
+                if (output.value) {
+                    maxEqualCount = std::max(maxEqualCount, ++valueCounts[output.value]);
+                }
+            }
+
+            if (maxEqualCount < COINJOIN_MIN_EQUAL_OUTPUTS || tx.inputIds.size() < maxEqualCount) {
+                return true;
+            }
+
+            count(0);
+
+            return false;
+        }
+
+        bool addsEdges() const override {
+            return false;
+        }
+    };
+
+    std::unique_ptr<ClusterHeuristic> createClusterHeuristic(const std::string& name) {
+        if (name == "multi_input") {
+            return std::make_unique<MultiInputHeuristic>();
+        }
+        else if (name == "round_change") {
+            return std::make_unique<RoundChangeHeuristic>();
+        }
+        else if (name == "coinjoin") {
+            return std::make_unique<CoinJoinHeuristic>();
+        }
+
+        throw std::invalid_argument(fmt::format("Unknown cluster heuristic: {}", name));
+    }
+
+    ClusterHeuristics::ClusterHeuristics(
+        const std::vector<std::string>& names,
+        const IdBitset* excludeAddresses,
+        bool excludeInputs
+    ) : _excludeAddresses(excludeAddresses), _excludeInputs(excludeInputs), _excludedTxCount(0) {
+        for (const auto& name : names) {
+            _heuristics.push_back(createClusterHeuristic(name));
+        }
+
+        // A skipped tx must not have been merged by an earlier heuristic
+        std::stable_partition(_heuristics.begin(), _heuristics.end(), [](const auto& heuristic) {
+            return !heuristic->addsEdges();
+        });
+    }
+
+    void ClusterHeuristics::applyToBlock(const nlohmann::json& block, const EdgeFunc& addEdge) const {
+        HeuristicTx heuristicTx;
+
+        for (const auto& tx : utils::json::get(block, "tx")) {
+            heuristicTx.inputIds.clear();
+            heuristicTx.outputs.clear();
+
+            for (const auto& input : utils::json::get(tx, "inputs")) {
+                const auto prevOutItem = input.find("prev_out");
+                if (prevOutItem == input.cend()) {
+                    continue;
+                }
+
+                const auto addrItem = prevOutItem->find("addr");
+                if (addrItem != prevOutItem->cend()) {
+                    heuristicTx.inputIds.push_back(addrItem->get<BtcId>());
+                }
+            }
+
+            std::sort(heuristicTx.inputIds.begin(), heuristicTx.inputIds.end());
+            heuristicTx.inputIds.erase(
+                std::unique(heuristicTx.inputIds.begin(), heuristicTx.inputIds.end()), heuristicTx.inputIds.end()
+            );
+
+            for (const auto& output : utils::json::get(tx, "out")) {
+                const auto addrItem = output.find("addr");
+                const auto valueItem = output.find("value");
+
+                heuristicTx.outputs.push_back(HeuristicTxOutput{
+                    addrItem != output.cend() ? addrItem->get<BtcId>() : NO_ADDRESS_ID,
+                    valueItem != output.cend() ? valueItem->get<uint64_t>() : 0
+                });
+            }
+
+            applyToTx(heuristicTx, addEdge);
+        }
+    }
+
+    void ClusterHeuristics::applyToTx(const HeuristicTx& tx, const EdgeFunc& addEdge) const {
+        if (isExcluded(tx)) {
+            _excludedTxCount.fetch_add(1, std::memory_order_relaxed);
+
+            return;
+        }
+
+        for (const auto& heuristic : _heuristics) {
+            if (!heuristic->apply(tx, addEdge)) {
+                break;
+            }
+        }
+    }
+
+    bool ClusterHeuristics::isExcluded(const HeuristicTx& tx) const {
+        if (!_excludeAddresses) {
+            return false;
+        }
+
+        for (const auto& output : tx.outputs) {
+            if (output.addressId != NO_ADDRESS_ID && _excludeAddresses->contains(output.addressId)) {
+                return true;
+            }
+        }
+
+        if (_excludeInputs) {
+            for (auto inputId : tx.inputIds) {
+                if (_excludeAddresses->contains(inputId)) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> ClusterHeuristics::getCounters() const {
+        std::vector<std::pair<std::string, uint64_t>> counters;
+        if (_excludeAddresses) {
+            counters.push_back(std::make_pair("exclude_addrs.excluded_txs", _excludedTxCount.load(std::memory_order_relaxed)));
+        }
+
+        for (const auto& heuristic : _heuristics) {
+            for (const auto& [counterName, counterValue] : heuristic->getCounters()) {
+                counters.push_back(std::make_pair(fmt::format("{}.{}", heuristic->getName(), counterName), counterValue));
+            }
+        }
+
+        return counters;
+    }
+}
@@ -0,0 +1,159 @@
+#include "utils/day_inputs.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace utils::btc {
+    namespace fs = std::filesystem;
+
+    static const char DAY_INPUTS_FILE_MAGIC[8] = { 'B', 'T', 'C', 'D', 'A', 'Y', 'I', 'N' };
+    static const uint32_t DAY_INPUTS_FILE_VERSION = 1;
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    static void appendVarint(std::vector<uint8_t>& data, uint64_t value) {
+        while (value >= 0x80) {
+            data.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        data.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool isBinaryDayInputsPath(const fs::path& path) {
+        return path.extension() == ".bin";
+    }
+
+    void dumpBinaryDayInputs(
+        const fs::path& path,
+        const std::vector<std::vector<std::vector<BtcId>>>& blocks,
+        DayInputsEncoding encoding
+    ) {
+        std::vector<uint64_t> blockOffsets(1, 0);
+        std::vector<uint64_t> txOffsets(1, 0);
+        std::vector<BtcId> rawIds;
+        std::vector<uint8_t> encodedIds;
+        uint64_t idCount = 0;
+
+        for (const auto& txs : blocks) {
+            for (const auto& inputs : txs) {
+                if (encoding == DayInputsEncoding::Raw) {
+                    rawIds.insert(rawIds.end(), inputs.cbegin(), inputs.cend());
+                    txOffsets.push_back(rawIds.size());
+                }
+                else {
+                    BtcId previousId = 0;
+                    for (auto input : inputs) {
+                        if (input < previousId) {
+                            throw std::invalid_argument(fmt::format("Tx inputs must be sorted for {}", path.string()));
+                        }
+
+                        appendVarint(encodedIds, input - previousId);
+                        previousId = input;
+                    }
+                    txOffsets.push_back(encodedIds.size());
+                }
+
+                idCount += inputs.size();
+            }
+
+            blockOffsets.push_back(txOffsets.size() - 1);
+        }
+
+        DayInputsFileHeader header = {};
+        std::copy(std::begin(DAY_INPUTS_FILE_MAGIC), std::end(DAY_INPUTS_FILE_MAGIC), header.magic);
+        header.version = DAY_INPUTS_FILE_VERSION;
+        header.byteOrderMark = BYTE_ORDER_MARK;
+        header.idBytes = sizeof(BtcId);
+        header.encoding = static_cast<uint32_t>(encoding);
+        header.blockCount = blocks.size();
+        header.txCount = txOffsets.size() - 1;
+        header.idCount = idCount;
+        header.blockOffsetsOffset = sizeof(header);
+        header.txOffsetsOffset = header.blockOffsetsOffset + blockOffsets.size() * sizeof(uint64_t);
+        header.idsOffset = header.txOffsetsOffset + txOffsets.size() * sizeof(uint64_t);
+        header.idsSize = encoding == DayInputsEncoding::Raw ? rawIds.size() * sizeof(BtcId) : encodedIds.size();
+
+        std::ofstream outputFile(path, std::ios::binary);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open file {}", path.string()));
+        }
+
+        outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outputFile.write(reinterpret_cast<const char*>(blockOffsets.data()), blockOffsets.size() * sizeof(uint64_t));
+        outputFile.write(reinterpret_cast<const char*>(txOffsets.data()), txOffsets.size() * sizeof(uint64_t));
+        if (encoding == DayInputsEncoding::Raw) {
+            outputFile.write(reinterpret_cast<const char*>(rawIds.data()), header.idsSize);
+        }
+        else {
+            outputFile.write(reinterpret_cast<const char*>(encodedIds.data()), header.idsSize);
+        }
+
+        if (!outputFile) {
+            throw std::runtime_error(fmt::format("Can't write file {}", path.string()));
+        }
+    }
+
+    DayInputsView::DayInputsView(const fs::path& path) : _file(path.string()) {
+        DayInputsFileHeader header;
+        if (_file.size() < sizeof(header) ||
+            !std::equal(std::begin(DAY_INPUTS_FILE_MAGIC), std::end(DAY_INPUTS_FILE_MAGIC), _file.data())) {
+            throw std::runtime_error(fmt::format("Not a binary day inputs file: {}", path.string()));
+        }
+        std::memcpy(&header, _file.data(), sizeof(header));
+
+        if (header.byteOrderMark != BYTE_ORDER_MARK) {
+            throw std::runtime_error(fmt::format("Day inputs file {} is written in another byte order", path.string()));
+        }
+
+        if (header.version > DAY_INPUTS_FILE_VERSION) {
+            throw std::runtime_error(fmt::format(
+                "Day inputs file {} has unsupported version {}", path.string(), header.version
+            ));
+        }
+
+        if (header.idBytes != sizeof(BtcId)) {
+            throw std::runtime_error(fmt::format(
+                "Day inputs file {} has {} bytes ids, expected {}", path.string(), header.idBytes, sizeof(BtcId)
+            ));
+        }
+
+        if (header.encoding > static_cast<uint32_t>(DayInputsEncoding::DeltaVarint)) {
+            throw std::runtime_error(fmt::format("Day inputs file {} has unknown encoding {}", path.string(), header.encoding));
+        }
+
+        uint64_t txOffsetsEnd = header.txOffsetsOffset + (header.txCount + 1) * sizeof(uint64_t);
+        if (header.idsOffset < txOffsetsEnd || header.idsOffset + header.idsSize > _file.size()) {
+            throw std::runtime_error(fmt::format("Day inputs file {} is truncated", path.string()));
+        }
+
+        _encoding = static_cast<DayInputsEncoding>(header.encoding);
+        _blockCount = header.blockCount;
+        _txCount = header.txCount;
+        _idCount = header.idCount;
+        _txOffsets = reinterpret_cast<const uint64_t*>(_file.data() + header.txOffsetsOffset);
+        _ids = reinterpret_cast<const uint8_t*>(_file.data() + header.idsOffset);
+
+        // forEachTx trusts the offsets, so they are checked once here: non-decreasing from 0 to the end of
+        // the ids, and every varint tx ends with a last varint byte so decoding never runs past it
+        uint64_t idsEnd = _encoding == DayInputsEncoding::Raw ? header.idsSize / sizeof(BtcId) : header.idsSize;
+        if (_txOffsets[0] != 0 || _txOffsets[_txCount] != idsEnd) {
+            throw std::runtime_error(fmt::format("Day inputs file {} has inconsistent tx offsets", path.string()));
+        }
+
+        for (uint64_t txIndex = 0; txIndex != _txCount; ++txIndex) {
+            uint64_t txBegin = _txOffsets[txIndex];
+            uint64_t txEnd = _txOffsets[txIndex + 1];
+            if (txBegin > txEnd || txEnd > idsEnd) {
+                throw std::runtime_error(fmt::format(
+                    "Day inputs file {} has invalid offsets of tx {}: {}, {}", path.string(), txIndex, txBegin, txEnd
+                ));
+            }
+
+            if (_encoding == DayInputsEncoding::DeltaVarint && txBegin != txEnd && (_ids[txEnd - 1] & 0x80)) {
+                throw std::runtime_error(fmt::format("Day inputs file {} has a truncated varint in tx {}", path.string(), txIndex));
+            }
+        }
+    }
+}
@@ -0,0 +1,202 @@
+#include "utils/entity_index.h"
+#include "utils/task_utils.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace utils::btc {
+    namespace fs = std::filesystem;
+
+    static const char ENTITY_INDEX_FILE_MAGIC[8] = { 'B', 'T', 'C', 'U', 'F', 'I', 'D', 'X' };
+    static const uint32_t ENTITY_INDEX_FILE_VERSION = 2;
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    static int64_t getModifiedTime(const fs::path& path) {
+        return fs::last_write_time(path).time_since_epoch().count();
+    }
+
+    fs::path getEntityIndexPath(const fs::path& unionFindFilePath) {
+        return fs::path(unionFindFilePath.string() + ".idx");
+    }
+
+    void buildEntityIndex(const UnionFindView& quickUnion, const fs::path& path, uint32_t workerCount) {
+        BtcSize idCount = quickUnion.getSize();
+
+        // Counting sort by root: count members of every root
+        std::vector<BtcId> cursors(idCount, 0);
+        utils::runRangesInParallel(idCount, workerCount, [&](BtcId beginId, BtcId endId) {
+            for (BtcId p = beginId; p != endId; ++p) {
+                std::atomic_ref<BtcId>(cursors[quickUnion.findRoot(p)]).fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        // Every root counts at least itself, turn counts into the first member position of each root
+        std::vector<BtcIdStorage> roots;
+        std::vector<BtcIdStorage> offsets;
+        roots.reserve(quickUnion.getClusterCount());
+        offsets.reserve(quickUnion.getClusterCount() + 1);
+
+        BtcId memberOffset = 0;
+        for (BtcId p = 0; p != idCount; ++p) {
+            BtcId memberCount = cursors[p];
+            if (!memberCount) {
+                continue;
+            }
+
+            roots.push_back(p);
+            offsets.push_back(memberOffset);
+            cursors[p] = memberOffset;
+            memberOffset += memberCount;
+        }
+        offsets.push_back(memberOffset);
+
+        std::vector<BtcIdStorage> members(idCount);
+        utils::runRangesInParallel(idCount, workerCount, [&](BtcId beginId, BtcId endId) {
+            for (BtcId p = beginId; p != endId; ++p) {
+                BtcId memberIndex = std::atomic_ref<BtcId>(cursors[quickUnion.findRoot(p)])
+                    .fetch_add(1, std::memory_order_relaxed);
+                members[memberIndex] = p;
+            }
+        });
+
+        // Workers scatter their own id ranges, so members are sorted except across range boundaries
+        BtcSize entityCount = roots.size();
+        utils::runRangesInParallel(entityCount, workerCount, [&](BtcSize beginEntity, BtcSize endEntity) {
+            for (BtcSize entityIndex = beginEntity; entityIndex != endEntity; ++entityIndex) {
+                std::sort(
+                    members.begin() + BtcId(offsets[entityIndex]),
+                    members.begin() + BtcId(offsets[entityIndex + 1]),
+                    [](BtcId lhs, BtcId rhs) { return lhs < rhs; }
+                );
+            }
+        });
+
+        EntityIndexFileHeader header = {};
+        std::copy(ENTITY_INDEX_FILE_MAGIC, ENTITY_INDEX_FILE_MAGIC + sizeof(ENTITY_INDEX_FILE_MAGIC), header.magic);
+        header.version = ENTITY_INDEX_FILE_VERSION;
+        header.byteOrderMark = BYTE_ORDER_MARK;
+        header.idBytes = sizeof(BtcIdStorage);
+        header.entityCount = entityCount;
+        header.idCount = idCount;
+        header.rootsOffset = sizeof(header);
+        header.offsetsOffset = header.rootsOffset + roots.size() * sizeof(BtcIdStorage);
+        header.membersOffset = header.offsetsOffset + offsets.size() * sizeof(BtcIdStorage);
+        header.sourceFileSize = quickUnion.getFileSize();
+        header.sourceModifiedTime = getModifiedTime(quickUnion.getPath());
+        header.sourceChecksum = quickUnion.getChecksum();
+
+        std::ofstream outputFile(path.c_str(), std::ios::binary);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open entity index file {}", path.string()));
+        }
+
+        outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outputFile.write(reinterpret_cast<const char*>(roots.data()), roots.size() * sizeof(BtcIdStorage));
+        outputFile.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(BtcIdStorage));
+        outputFile.write(reinterpret_cast<const char*>(members.data()), members.size() * sizeof(BtcIdStorage));
+
+        if (!outputFile) {
+            throw std::runtime_error(fmt::format("Can't write entity index file {}", path.string()));
+        }
+    }
+
+    std::unique_ptr<EntityIndexView> loadEntityIndexOf(const UnionFindView& quickUnion) {
+        fs::path path = getEntityIndexPath(quickUnion.getPath());
+        if (!fs::exists(path)) {
+            return nullptr;
+        }
+
+        auto entityIndex = std::make_unique<EntityIndexView>(path);
+        if (!entityIndex->matches(quickUnion)) {
+            std::cerr << fmt::format("Entity index {} is outdated, ignore it", path.string()) << std::endl;
+
+            return nullptr;
+        }
+
+        return entityIndex;
+    }
+
+    EntityIndexView::EntityIndexView(const fs::path& path) :
+        _file(path.string()), _roots(nullptr), _offsets(nullptr), _members(nullptr), _entityCount(0), _idCount(0),
+        _sourceFileSize(0), _sourceModifiedTime(0), _sourceChecksum(0) {
+        EntityIndexFileHeader header = {};
+        if (_file.size() < sizeof(header) ||
+            !std::equal(ENTITY_INDEX_FILE_MAGIC, ENTITY_INDEX_FILE_MAGIC + sizeof(ENTITY_INDEX_FILE_MAGIC), _file.data())) {
+            throw std::runtime_error(fmt::format("Invalid entity index file {}", path.string()));
+        }
+
+        std::copy(_file.data(), _file.data() + sizeof(header), reinterpret_cast<char*>(&header));
+        if (header.byteOrderMark != BYTE_ORDER_MARK || header.idBytes != sizeof(BtcIdStorage)) {
+            throw std::runtime_error(fmt::format(
+                "Entity index file {} has {} bytes ids or another byte order", path.string(), header.idBytes
+            ));
+        }
+
+        if (header.version > ENTITY_INDEX_FILE_VERSION) {
+            throw std::runtime_error(fmt::format(
+                "Entity index file {} has unsupported version {}", path.string(), header.version
+            ));
+        }
+
+        if (header.membersOffset + header.idCount * sizeof(BtcIdStorage) > _file.size()) {
+            throw std::runtime_error(fmt::format("Entity index file {} is truncated", path.string()));
+        }
+
+        _entityCount = header.entityCount;
+        _idCount = header.idCount;
+        // Version 1 has no source fields, its index never matches and has to be rebuilt
+        if (header.version >= 2) {
+            _sourceFileSize = header.sourceFileSize;
+            _sourceModifiedTime = header.sourceModifiedTime;
+            _sourceChecksum = header.sourceChecksum;
+        }
+        _roots = reinterpret_cast<const BtcIdStorage*>(_file.data() + header.rootsOffset);
+        _offsets = reinterpret_cast<const BtcIdStorage*>(_file.data() + header.offsetsOffset);
+        _members = reinterpret_cast<const BtcIdStorage*>(_file.data() + header.membersOffset);
+    }
+
+    bool EntityIndexView::matches(const UnionFindView& quickUnion) const {
+        if (_idCount != quickUnion.getSize() || _entityCount != quickUnion.getClusterCount() ||
+            _sourceFileSize != quickUnion.getFileSize()) {
+            return false;
+        }
+
+        if (quickUnion.getChecksum()) {
+            return _sourceChecksum == quickUnion.getChecksum();
+        }
+
+        return _sourceModifiedTime == getModifiedTime(quickUnion.getPath());
+    }
+
+    BtcSize EntityIndexView::findEntity(BtcId rootId) const {
+        auto rootIt = std::lower_bound(_roots, _roots + _entityCount, rootId, [](BtcId lhs, BtcId rhs) {
+            return lhs < rhs;
+        });
+        if (rootIt == _roots + _entityCount || BtcId(*rootIt) != rootId) {
+            return NO_ENTITY;
+        }
+
+        return rootIt - _roots;
+    }
+
+    EntityIndexView::Members EntityIndexView::getMembers(BtcSize entityIndex) const {
+        BtcId beginOffset = _offsets[entityIndex];
+        BtcId endOffset = _offsets[entityIndex + 1];
+
+        return Members(_members + beginOffset, endOffset - beginOffset);
+    }
+
+    EntityIndexView::Members EntityIndexView::getMembersOfRoot(BtcId rootId) const {
+        BtcSize entityIndex = findEntity(rootId);
+        if (entityIndex == NO_ENTITY) {
+            return Members();
+        }
+
+        return getMembers(entityIndex);
+    }
+}
@@ -0,0 +1,191 @@
+#include "utils/id2address.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace utils::btc {
+    namespace fs = std::filesystem;
+
+    static const char ID2ADDRESS_FILE_MAGIC[8] = { 'B', 'T', 'C', 'I', 'D', '2', 'A', 'D' };
+    static const uint32_t ID2ADDRESS_FILE_VERSION = 1;
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static const std::size_t WRITE_BUFFER_SIZE = 64 * 1024 * 1024;
+
+    bool isBinaryId2AddressPath(const fs::path& path) {
+        return path.extension() == ".bin";
+    }
+
+    Id2AddressView::Id2AddressView(const fs::path& path) :
+        _file(path.string()),
+        _addressCount(0),
+        _offsets(nullptr),
+        _addresses(nullptr),
+        _slotCount(0),
+        _slots(nullptr) {
+        if (_file.size() >= sizeof(ID2ADDRESS_FILE_MAGIC) &&
+            std::equal(std::begin(ID2ADDRESS_FILE_MAGIC), std::end(ID2ADDRESS_FILE_MAGIC), _file.data())) {
+            mapBinaryFile(path);
+        }
+        else if (isBinaryId2AddressPath(path)) {
+            throw std::runtime_error(fmt::format("Not a binary id2addr file: {}", path.string()));
+        }
+        else {
+            indexTextFile();
+        }
+    }
+
+    void Id2AddressView::mapBinaryFile(const fs::path& path) {
+        Id2AddressFileHeader header;
+        if (_file.size() < sizeof(header)) {
+            throw std::runtime_error(fmt::format("Id2addr file {} is truncated", path.string()));
+        }
+        std::memcpy(&header, _file.data(), sizeof(header));
+
+        if (header.byteOrderMark != BYTE_ORDER_MARK) {
+            throw std::runtime_error(fmt::format("Id2addr file {} is written in another byte order", path.string()));
+        }
+
+        if (header.version > ID2ADDRESS_FILE_VERSION) {
+            throw std::runtime_error(fmt::format(
+                "Id2addr file {} has unsupported version {}", path.string(), header.version
+            ));
+        }
+
+        if (header.idBytes != sizeof(BtcId)) {
+            throw std::runtime_error(fmt::format(
+                "Id2addr file {} has {} bytes ids, expected {}", path.string(), header.idBytes, sizeof(BtcId)
+            ));
+        }
+
+        uint64_t offsetsEnd = header.offsetsOffset + (header.addressCount + 1) * sizeof(uint64_t);
+        uint64_t slotsEnd = header.slotsOffset + header.slotCount * sizeof(BtcId);
+        if (offsetsEnd > header.addressesOffset || header.addressesOffset + header.addressesSize > _file.size() ||
+            (header.slotCount && slotsEnd > _file.size())) {
+            throw std::runtime_error(fmt::format("Id2addr file {} is truncated", path.string()));
+        }
+
+        _addressCount = header.addressCount;
+        _offsets = reinterpret_cast<const uint64_t*>(_file.data() + header.offsetsOffset);
+        _addresses = _file.data() + header.addressesOffset;
+        _slotCount = header.slotCount;
+        _slots = header.slotCount ? reinterpret_cast<const BtcId*>(_file.data() + header.slotsOffset) : nullptr;
+
+        if (_offsets[_addressCount] != header.addressesSize) {
+            throw std::runtime_error(fmt::format("Id2addr file {} has inconsistent offsets", path.string()));
+        }
+
+        if (_slotCount & (_slotCount - 1)) {
+            throw std::runtime_error(fmt::format("Id2addr file {} has {} hash slots", path.string(), _slotCount));
+        }
+    }
+
+    void Id2AddressView::indexTextFile() {
+        const char* data = _file.data();
+        std::size_t dataSize = _file.size();
+
+        _textOffsets.reserve(dataSize / 35 + 1);
+        uint64_t lineBegin = 0;
+        while (lineBegin < dataSize) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(data + lineBegin, '\n', dataSize - lineBegin));
+            uint64_t lineEndOffset = lineEnd ? lineEnd - data : dataSize;
+            if (lineEndOffset == lineBegin) {
+                break;
+            }
+
+            _textOffsets.push_back(lineBegin);
+            lineBegin = lineEndOffset + 1;
+        }
+        // A last line without '\n' still ends one byte before this
+        _textOffsets.push_back(lineBegin);
+
+        _addressCount = _textOffsets.size() - 1;
+        _offsets = _textOffsets.data();
+        _addresses = data;
+    }
+
+    BtcId Id2AddressView::find(std::string_view address) const {
+        if (!_slotCount) {
+            throw std::runtime_error("Id2addr file has no hash index");
+        }
+
+        uint64_t slotMask = _slotCount - 1;
+        for (uint64_t slotIndex = hashAddressFnv1a(address) & slotMask; ; slotIndex = (slotIndex + 1) & slotMask) {
+            BtcId addressId = _slots[slotIndex];
+            if (addressId == NO_ID || getAddress(addressId) == address) {
+                return addressId;
+            }
+        }
+    }
+
+    void Id2AddressView::dump(const fs::path& path, bool withHashIndex) const {
+        std::vector<uint64_t> offsets;
+        offsets.reserve(_addressCount + 1);
+        offsets.push_back(0);
+        for (BtcId addressId = 0; addressId != _addressCount; ++addressId) {
+            offsets.push_back(offsets.back() + getAddress(addressId).size() + 1);
+        }
+
+        std::vector<BtcId> slots;
+        if (withHashIndex) {
+            uint64_t slotCount = 1;
+            while (slotCount < _addressCount * 2) {
+                slotCount *= 2;
+            }
+
+            slots.assign(slotCount, NO_ID);
+            uint64_t slotMask = slotCount - 1;
+            for (BtcId addressId = 0; addressId != _addressCount; ++addressId) {
+                uint64_t slotIndex = hashAddressFnv1a(getAddress(addressId)) & slotMask;
+                while (slots[slotIndex] != NO_ID) {
+                    slotIndex = (slotIndex + 1) & slotMask;
+                }
+
+                slots[slotIndex] = addressId;
+            }
+        }
+
+        Id2AddressFileHeader header = {};
+        std::copy(std::begin(ID2ADDRESS_FILE_MAGIC), std::end(ID2ADDRESS_FILE_MAGIC), header.magic);
+        header.version = ID2ADDRESS_FILE_VERSION;
+        header.byteOrderMark = BYTE_ORDER_MARK;
+        header.idBytes = sizeof(BtcId);
+        header.addressCount = _addressCount;
+        header.offsetsOffset = sizeof(header);
+        header.addressesOffset = header.offsetsOffset + offsets.size() * sizeof(uint64_t);
+        header.addressesSize = offsets.back();
+        // Slots start 8 bytes aligned like the offsets
+        header.slotsOffset = (header.addressesOffset + header.addressesSize + 7) / 8 * 8;
+        header.slotCount = slots.size();
+
+        std::ofstream outputFile(path, std::ios::binary);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open file {}", path.string()));
+        }
+
+        outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outputFile.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+        std::string buffer;
+        buffer.reserve(WRITE_BUFFER_SIZE);
+        for (BtcId addressId = 0; addressId != _addressCount; ++addressId) {
+            buffer.append(getAddress(addressId));
+            buffer.push_back('\n');
+
+            if (buffer.size() >= WRITE_BUFFER_SIZE) {
+                outputFile.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        buffer.resize(buffer.size() + header.slotsOffset - header.addressesOffset - header.addressesSize, '\0');
+        outputFile.write(buffer.data(), buffer.size());
+
+        outputFile.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(BtcId));
+
+        if (!outputFile) {
+            throw std::runtime_error(fmt::format("Can't write file {}", path.string()));
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "utils/id_bitset.h"
+#include "utils/line_loader.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <stdexcept>
+
+namespace utils::btc {
+    // Bitmap files are this header followed by the 64 bit words of the bitset
+    struct IdBitsetFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t size;
+        uint64_t count;
+    };
+
+    static const char ID_BITSET_FILE_MAGIC[8] = { 'B', 'T', 'C', 'I', 'D', 'S', 'E', 'T' };
+    static const uint32_t ID_BITSET_FILE_VERSION = 1;
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    static std::size_t getWordCount(IdBitset::Size size) {
+        return (size + 63) / 64;
+    }
+
+    IdBitset::IdBitset(Size size) : _words(getWordCount(size), 0), _size(size) {
+    }
+
+    IdBitset IdBitset::loadIdList(const std::string& filePath) {
+        const auto& ids = utils::loadNumberLines<BtcId>(filePath);
+
+        // Sized once by the largest id instead of growing on inserts
+        IdBitset bitset;
+        if (!ids.empty()) {
+            bitset.resize(*std::max_element(ids.cbegin(), ids.cend()) + 1);
+        }
+        for (BtcId id : ids) {
+            bitset.insert(id);
+        }
+
+        return bitset;
+    }
+
+    IdBitset IdBitset::load(const std::string& filePath) {
+        std::ifstream bitmapFile(filePath, std::ios::binary);
+        if (!bitmapFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open bitmap {}", filePath));
+        }
+
+        IdBitsetFileHeader header;
+        bitmapFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!bitmapFile || !std::equal(std::begin(ID_BITSET_FILE_MAGIC), std::end(ID_BITSET_FILE_MAGIC), header.magic)) {
+            throw std::runtime_error(fmt::format("Not a bitmap file: {}", filePath));
+        }
+
+        if (header.byteOrderMark != BYTE_ORDER_MARK) {
+            throw std::runtime_error(fmt::format("Bitmap file {} is written in another byte order", filePath));
+        }
+
+        if (header.version > ID_BITSET_FILE_VERSION) {
+            throw std::runtime_error(fmt::format("Bitmap file {} has unsupported version {}", filePath, header.version));
+        }
+
+        IdBitset bitset(header.size);
+        bitmapFile.read(reinterpret_cast<char*>(bitset._words.data()), bitset._words.size() * sizeof(uint64_t));
+        if (!bitmapFile) {
+            throw std::runtime_error(fmt::format("Bitmap file {} is truncated", filePath));
+        }
+
+        return bitset;
+    }
+
+    void IdBitset::save(const std::string& filePath) const {
+        IdBitsetFileHeader header = {};
+        std::copy(std::begin(ID_BITSET_FILE_MAGIC), std::end(ID_BITSET_FILE_MAGIC), header.magic);
+        header.version = ID_BITSET_FILE_VERSION;
+        header.byteOrderMark = BYTE_ORDER_MARK;
+        header.size = _size;
+        header.count = count();
+
+        std::ofstream bitmapFile(filePath, std::ios::binary);
+        bitmapFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        bitmapFile.write(reinterpret_cast<const char*>(_words.data()), _words.size() * sizeof(uint64_t));
+        if (!bitmapFile) {
+            throw std::runtime_error(fmt::format("Can't write bitmap {}", filePath));
+        }
+    }
+
+    void IdBitset::resize(Size size) {
+        _words.resize(getWordCount(size), 0);
+
+        // Clear bits past the new end of the last word so they don't come back on growth
+        if (size < _size && size % 64) {
+            _words.back() &= (uint64_t(1) << (size % 64)) - 1;
+        }
+
+        _size = size;
+    }
+
+    IdBitset& IdBitset::operator|=(const IdBitset& rhs) {
+        if (rhs._size > _size) {
+            resize(rhs._size);
+        }
+
+        // Plain word loop, vectorized by the compiler
+        uint64_t* words = _words.data();
+        const uint64_t* rhsWords = rhs._words.data();
+        std::size_t wordCount = rhs._words.size();
+        for (std::size_t wordIndex = 0; wordIndex != wordCount; ++wordIndex) {
+            words[wordIndex] |= rhsWords[wordIndex];
+        }
+
+        return *this;
+    }
+
+    IdBitset::Size IdBitset::count() const {
+        Size idCount = 0;
+        for (auto word : _words) {
+            idCount += std::popcount(word);
+        }
+
+        return idCount;
+    }
+}
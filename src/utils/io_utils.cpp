@@ -1,9 +1,13 @@
 #include "btc-config.h"
 #include "utils/io_utils.h"
+#include "utils/mmap_utils.h"
 #include "fmt/format.h"
 
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 
 namespace utils {
     std::string readFile(const std::string& filePath)
@@ -90,4 +94,56 @@ namespace utils {
             os.write(str.c_str(), size);
         }
     }
+
+    std::ofstream openLinesForAppend(const std::string& filePath, uint64_t lineCount) {
+        uint64_t keptSize = 0;
+        bool needsNewLine = false;
+        if (std::filesystem::exists(filePath)) {
+            {
+                utils::mmap::MappedFile inputFile(filePath);
+                const char* data = inputFile.data();
+                const char* dataEnd = data + inputFile.size();
+
+                const char* lineBegin = data;
+                for (uint64_t lineIndex = 0; lineIndex != lineCount; ++lineIndex) {
+                    if (lineBegin == dataEnd) {
+                        throw std::runtime_error(fmt::format(
+                            "File {} has {} lines, expected {}", filePath, lineIndex, lineCount
+                        ));
+                    }
+
+                    const char* lineEnd = static_cast<const char*>(std::memchr(lineBegin, '\n', dataEnd - lineBegin));
+                    if (lineEnd == lineBegin) {
+                        throw std::runtime_error(fmt::format("Empty line {} in {}", lineIndex + 1, filePath));
+                    }
+
+                    needsNewLine = !lineEnd;
+                    lineBegin = lineEnd ? lineEnd + 1 : dataEnd;
+                }
+                keptSize = lineBegin - data;
+
+                for (const char* rest = lineBegin; rest != dataEnd; ++rest) {
+                    if (*rest != '\n' && *rest != '\r') {
+                        throw std::runtime_error(fmt::format(
+                            "File {} has content after line {}, at byte {}", filePath, lineCount, rest - data
+                        ));
+                    }
+                }
+            }
+
+            // Blank lines after the counted ones are cut once the file is unmapped
+            std::filesystem::resize_file(filePath, keptSize);
+        }
+
+        std::ofstream outputFile(filePath, std::ios::binary | std::ios::app);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        if (needsNewLine) {
+            outputFile.put('\n');
+        }
+
+        return outputFile;
+    }
 }
@@ -0,0 +1,23 @@
+#include "utils/line_loader.h"
+
+#include <algorithm>
+
+namespace utils {
+    std::vector<std::string_view> splitLineChunks(std::string_view text, std::size_t chunkCount) {
+        std::vector<std::string_view> chunks;
+        std::size_t chunkSize = text.size() / std::max<std::size_t>(chunkCount, 1) + 1;
+
+        std::size_t chunkBegin = 0;
+        while (chunkBegin < text.size()) {
+            // The last chunk takes the rest, so there are never more than chunkCount chunks
+            std::size_t chunkEnd = chunks.size() + 1 >= chunkCount ?
+                std::string_view::npos : text.find('\n', std::min(chunkBegin + chunkSize, text.size()) - 1);
+            chunkEnd = chunkEnd == std::string_view::npos ? text.size() : chunkEnd + 1;
+
+            chunks.push_back(text.substr(chunkBegin, chunkEnd - chunkBegin));
+            chunkBegin = chunkEnd;
+        }
+
+        return chunks;
+    }
+}
@@ -0,0 +1,178 @@
+#include "utils/mmap_utils.h"
+#include "fmt/format.h"
+
+#include <stdexcept>
+
+#ifdef __GNUC__
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_MSC_VER)
+#include <Windows.h>
+#endif //__GNUC__
+
+namespace utils::mmap {
+    #ifdef __GNUC__
+    MappedFile::MappedFile(const std::string& filePath) : _data(nullptr), _size(0) {
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0) {
+            close(fd);
+            throw std::runtime_error(fmt::format("Can't stat file {}", filePath));
+        }
+
+        _size = fileStat.st_size;
+        if (_size) {
+            void* mapped = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error(fmt::format("Can't map file {}", filePath));
+            }
+
+            _data = static_cast<const char*>(mapped);
+        }
+
+        // The mapping keeps its own reference to the file
+        close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (_data) {
+            munmap(const_cast<char*>(_data), _size);
+        }
+    }
+
+    WritableMappedFile::WritableMappedFile(const std::string& filePath, std::size_t size) : _data(nullptr), _size(size) {
+        int fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        if (ftruncate(fd, _size) != 0) {
+            ::close(fd);
+            throw std::runtime_error(fmt::format("Can't resize file {} to {} bytes", filePath, _size));
+        }
+
+        if (_size) {
+            void* mapped = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error(fmt::format("Can't map file {}", filePath));
+            }
+
+            _data = static_cast<char*>(mapped);
+        }
+
+        ::close(fd);
+    }
+
+    WritableMappedFile::~WritableMappedFile() {
+        close();
+    }
+
+    void WritableMappedFile::close() {
+        if (_data) {
+            msync(_data, _size, MS_SYNC);
+            munmap(_data, _size);
+            _data = nullptr;
+        }
+    }
+    #elif defined(_MSC_VER)
+    MappedFile::MappedFile(const std::string& filePath) :
+        _data(nullptr), _size(0), _fileHandle(INVALID_HANDLE_VALUE), _mappingHandle(nullptr) {
+        _fileHandle = CreateFileA(
+            filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+        );
+        if (_fileHandle == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(_fileHandle, &fileSize);
+        _size = fileSize.QuadPart;
+        if (!_size) {
+            return;
+        }
+
+        _mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mappingHandle) {
+            _data = static_cast<const char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        }
+
+        if (!_data) {
+            if (_mappingHandle) {
+                CloseHandle(_mappingHandle);
+            }
+            CloseHandle(_fileHandle);
+            throw std::runtime_error(fmt::format("Can't map file {}", filePath));
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if (_data) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mappingHandle) {
+            CloseHandle(_mappingHandle);
+        }
+        CloseHandle(_fileHandle);
+    }
+
+    WritableMappedFile::WritableMappedFile(const std::string& filePath, std::size_t size) :
+        _data(nullptr), _size(size), _fileHandle(INVALID_HANDLE_VALUE), _mappingHandle(nullptr) {
+        _fileHandle = CreateFileA(
+            filePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr
+        );
+        if (_fileHandle == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        if (!_size) {
+            return;
+        }
+
+        LARGE_INTEGER mappingSize;
+        mappingSize.QuadPart = _size;
+        _mappingHandle = CreateFileMappingA(
+            _fileHandle, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr
+        );
+        if (_mappingHandle) {
+            _data = static_cast<char*>(MapViewOfFile(_mappingHandle, FILE_MAP_WRITE, 0, 0, 0));
+        }
+
+        if (!_data) {
+            if (_mappingHandle) {
+                CloseHandle(_mappingHandle);
+            }
+            CloseHandle(_fileHandle);
+            throw std::runtime_error(fmt::format("Can't map file {}", filePath));
+        }
+    }
+
+    WritableMappedFile::~WritableMappedFile() {
+        close();
+    }
+
+    void WritableMappedFile::close() {
+        if (_data) {
+            FlushViewOfFile(_data, 0);
+            UnmapViewOfFile(_data);
+            _data = nullptr;
+        }
+        if (_mappingHandle) {
+            CloseHandle(_mappingHandle);
+            _mappingHandle = nullptr;
+        }
+        if (_fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(_fileHandle);
+            _fileHandle = INVALID_HANDLE_VALUE;
+        }
+    }
+    #endif //__GNUC__
+}
@@ -0,0 +1,215 @@
+#include "utils/sorted_merge.h"
+#include "utils/mmap_utils.h"
+#include "utils/task_utils.h"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace utils {
+    // Samples taken from every run per worker, more samples give more even parts
+    static const std::size_t SPLITTER_SAMPLES_PER_WORKER = 64;
+    static const std::size_t WRITE_BUFFER_SIZE = 16 * 1024 * 1024;
+
+    void PackedLines::push_back(std::string_view line) {
+        if (line.size() > LENGTH_MASK) {
+            throw std::length_error(fmt::format("Line of {} bytes is too long to pack", line.size()));
+        }
+
+        _lines.push_back((uint64_t(_arena.size()) << LENGTH_BITS) | line.size());
+        _arena.append(line);
+    }
+
+    void PackedLines::sort() {
+        std::sort(_lines.begin(), _lines.end(), [this](uint64_t lhs, uint64_t rhs) {
+            return std::string_view(_arena.data() + (lhs >> LENGTH_BITS), lhs & LENGTH_MASK) <
+                std::string_view(_arena.data() + (rhs >> LENGTH_BITS), rhs & LENGTH_MASK);
+        });
+    }
+
+    std::size_t PackedLines::lowerBound(std::string_view line) const {
+        std::size_t begin = 0;
+        std::size_t count = size();
+        while (count) {
+            std::size_t half = count / 2;
+            if ((*this)[begin + half] < line) {
+                begin += half + 1;
+                count -= half + 1;
+            }
+            else {
+                count = half;
+            }
+        }
+
+        return begin;
+    }
+
+    SortedFileRun::SortedFileRun(const std::string& filePath) :
+        _filePath(filePath),
+        _file(std::make_unique<utils::mmap::MappedFile>(filePath)),
+        _lineBegin(_file->data()),
+        _lineEnd(_file->data()),
+        _dataEnd(_file->data() + _file->size()) {
+        seekLine();
+    }
+
+    void SortedFileRun::pop() {
+        std::string_view line = front();
+        _lineBegin = _lineEnd == _dataEnd ? _dataEnd : _lineEnd + 1;
+        seekLine();
+
+        if (!empty() && front() < line) {
+            throw std::runtime_error(fmt::format("Lines of {} are not sorted: {} before {}", _filePath, line, front()));
+        }
+    }
+
+    void SortedFileRun::seekLine() {
+        while (_lineBegin != _dataEnd && *_lineBegin == '\n') {
+            ++_lineBegin;
+        }
+
+        _lineEnd = _lineBegin == _dataEnd ?
+            _dataEnd : static_cast<const char*>(std::memchr(_lineBegin, '\n', _dataEnd - _lineBegin));
+        if (!_lineEnd) {
+            _lineEnd = _dataEnd;
+        }
+    }
+
+    static std::vector<std::string> sampleSplitters(
+        const std::vector<PackedLines>& runs,
+        uint32_t partCount
+    ) {
+        std::vector<std::string> samples;
+        for (const auto& run : runs) {
+            std::size_t runSampleCount = std::min<std::size_t>(partCount * SPLITTER_SAMPLES_PER_WORKER, run.size());
+            for (std::size_t sampleIndex = 0; sampleIndex != runSampleCount; ++sampleIndex) {
+                samples.push_back(std::string(run[sampleIndex * run.size() / runSampleCount]));
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+
+        std::vector<std::string> splitters;
+        for (uint32_t partIndex = 1; partIndex < partCount && !samples.empty(); ++partIndex) {
+            const auto& splitter = samples[partIndex * samples.size() / partCount];
+            if (splitters.empty() || splitters.back() != splitter) {
+                splitters.push_back(splitter);
+            }
+        }
+
+        return splitters;
+    }
+
+    uint64_t writeSortedUniqueLines(
+        const std::string& filePath,
+        const std::vector<PackedLines>& runs,
+        uint32_t workerCount
+    ) {
+        // Part n holds the lines in [splitter n - 1, splitter n), so equal lines never span two parts
+        std::vector<std::string> splitters = sampleSplitters(runs, std::max(workerCount, 1u));
+        std::size_t partCount = splitters.size() + 1;
+
+        // Each part is merged once into its own buffer, its offset in the file is known when all are done
+        std::vector<std::string> partBuffers(partCount);
+        std::vector<uint64_t> partLineCounts(partCount, 0);
+        runRangesInParallel(partCount, workerCount, [&](uint64_t partBegin, uint64_t partEnd) {
+            for (uint64_t partIndex = partBegin; partIndex != partEnd; ++partIndex) {
+                std::vector<SortedPackedRun> partRuns;
+                for (const auto& run : runs) {
+                    std::size_t runBegin = partIndex ? run.lowerBound(splitters[partIndex - 1]) : 0;
+                    std::size_t runEnd = partIndex + 1 != partCount ? run.lowerBound(splitters[partIndex]) : run.size();
+                    partRuns.push_back(SortedPackedRun(run, runBegin, runEnd));
+                }
+
+                auto& partBuffer = partBuffers[partIndex];
+                auto& partLineCount = partLineCounts[partIndex];
+                mergeSortedUnique(partRuns, [&partBuffer, &partLineCount](std::string_view line) {
+                    partBuffer.append(line);
+                    partBuffer.push_back('\n');
+                    ++partLineCount;
+                });
+            }
+        });
+
+        std::vector<uint64_t> partOffsets(partCount + 1, 0);
+        for (std::size_t partIndex = 0; partIndex != partCount; ++partIndex) {
+            partOffsets[partIndex + 1] = partOffsets[partIndex] + partBuffers[partIndex].size();
+        }
+
+        utils::mmap::WritableMappedFile outputFile(filePath, partOffsets[partCount]);
+        runRangesInParallel(partCount, workerCount, [&](uint64_t partBegin, uint64_t partEnd) {
+            for (uint64_t partIndex = partBegin; partIndex != partEnd; ++partIndex) {
+                auto& partBuffer = partBuffers[partIndex];
+                std::memcpy(outputFile.data() + partOffsets[partIndex], partBuffer.data(), partBuffer.size());
+                std::string().swap(partBuffer);
+            }
+        });
+        outputFile.close();
+
+        uint64_t lineCount = 0;
+        for (auto partLineCount : partLineCounts) {
+            lineCount += partLineCount;
+        }
+
+        return lineCount;
+    }
+
+    void dumpSortedRun(const std::string& filePath, const PackedLines& lines) {
+        std::ofstream outputFile(filePath, std::ios::binary);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open file {}", filePath));
+        }
+
+        std::string buffer;
+        buffer.reserve(WRITE_BUFFER_SIZE);
+        for (std::size_t lineIndex = 0; lineIndex != lines.size(); ++lineIndex) {
+            buffer.append(lines[lineIndex]);
+            buffer.push_back('\n');
+
+            if (buffer.size() >= WRITE_BUFFER_SIZE) {
+                outputFile.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        outputFile.write(buffer.data(), buffer.size());
+
+        if (!outputFile) {
+            throw std::runtime_error(fmt::format("Can't write file {}", filePath));
+        }
+    }
+
+    uint64_t mergeSortedUniqueFiles(const std::string& outputFilePath, const std::vector<std::string>& inputFilePaths) {
+        std::vector<SortedFileRun> runs;
+        for (const auto& inputFilePath : inputFilePaths) {
+            runs.push_back(SortedFileRun(inputFilePath));
+        }
+
+        std::ofstream outputFile(outputFilePath, std::ios::binary);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open file {}", outputFilePath));
+        }
+
+        uint64_t lineCount = 0;
+        std::string buffer;
+        buffer.reserve(WRITE_BUFFER_SIZE);
+        mergeSortedUnique(runs, [&](std::string_view line) {
+            buffer.append(line);
+            buffer.push_back('\n');
+            ++lineCount;
+
+            if (buffer.size() >= WRITE_BUFFER_SIZE) {
+                outputFile.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        });
+        outputFile.write(buffer.data(), buffer.size());
+
+        if (!outputFile) {
+            throw std::runtime_error(fmt::format("Can't write file {}", outputFilePath));
+        }
+
+        return lineCount;
+    }
+}
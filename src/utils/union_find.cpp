@@ -1,14 +1,85 @@
 #include "utils/union_find.h"
+#include "utils/task_utils.h"
 #include "fmt/format.h"
 
 #include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <atomic>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif //_MSC_VER
 
 namespace utils::btc {
     namespace fs = std::filesystem;
 
-    WeightedQuickUnion::WeightedQuickUnion(BtcSize idCount) :
+    static inline void prefetchRead(const void* address) {
+        #ifdef __GNUC__
+        __builtin_prefetch(address, 0, 1);
+        #elif defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T1);
+        #endif //__GNUC__
+    }
+
+    // Number of root walks kept in flight by findRoots
+    static const std::size_t FIND_ROOTS_GROUP_SIZE = 16;
+
+    // Advances a group of root walks in turn and prefetches the next parent of each walk before
+    // coming back to it, so the cache misses of the group overlap instead of stalling one by one.
+    // A finished walk hands its slot to the next input (asynchronous memory access chaining).
+    template <typename IdStorage, typename Id>
+    static void findRootsInterleaved(const IdStorage* ids, std::span<const Id> in, std::span<Id> out) {
+        Id currentIds[FIND_ROOTS_GROUP_SIZE];
+        std::size_t outIndexes[FIND_ROOTS_GROUP_SIZE];
+
+        std::size_t inputCount = in.size();
+        std::size_t nextInput = 0;
+        std::size_t activeCount = 0;
+        for (; activeCount != FIND_ROOTS_GROUP_SIZE && nextInput != inputCount; ++activeCount, ++nextInput) {
+            currentIds[activeCount] = in[nextInput];
+            outIndexes[activeCount] = nextInput;
+            prefetchRead(ids + currentIds[activeCount]);
+        }
+
+        while (activeCount) {
+            for (std::size_t slot = 0; slot < activeCount;) {
+                Id parent = ids[currentIds[slot]];
+                if (parent != currentIds[slot]) {
+                    currentIds[slot] = parent;
+                    prefetchRead(ids + parent);
+                    ++slot;
+
+                    continue;
+                }
+
+                out[outIndexes[slot]] = parent;
+
+                if (nextInput != inputCount) {
+                    currentIds[slot] = in[nextInput];
+                    outIndexes[slot] = nextInput;
+                    prefetchRead(ids + currentIds[slot]);
+                    ++nextInput;
+                    ++slot;
+                }
+                else {
+                    // Move the last walk into this slot and look at it in this round
+                    --activeCount;
+                    currentIds[slot] = currentIds[activeCount];
+                    outIndexes[slot] = outIndexes[activeCount];
+                }
+            }
+        }
+    }
+
+    template <typename IdStorage>
+    BasicWeightedQuickUnion<IdStorage>::BasicWeightedQuickUnion(Size idCount) :
         _ids(idCount, 0), _sizes(idCount, 1), _clusterCount(idCount) {
-        BtcSize currentId = 0;
+        Size currentId = 0;
         for (auto& id : _ids) {
             id = currentId;
 
@@ -16,85 +87,487 @@ namespace utils::btc {
         }
     }
 
-    bool WeightedQuickUnion::connected(BtcId p, BtcId q) {
+    template <typename IdStorage>
+    bool BasicWeightedQuickUnion<IdStorage>::connected(Id p, Id q) {
         return findRoot(p) == findRoot(q);
     }
 
-    BtcId WeightedQuickUnion::findRoot(BtcId p) const {
+    template <typename IdStorage>
+    typename BasicWeightedQuickUnion<IdStorage>::Id BasicWeightedQuickUnion<IdStorage>::findRoot(Id p) const {
         while (p != _ids[p]) {
             p = _ids[p];
         }
 
         return p;
-    }
-
-    BtcSize WeightedQuickUnion::getClusterSize(BtcId p) const {
-        auto pRoot = _ids[p];
+    }
+
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::findRoots(std::span<const Id> in, std::span<Id> out) const {
+        findRootsInterleaved(_ids.data(), in, out);
+    }
+
+    template <typename IdStorage>
+    typename BasicWeightedQuickUnion<IdStorage>::Size BasicWeightedQuickUnion<IdStorage>::getClusterSize(Id p) const {
+        Id pRoot = _ids[p];
         if (pRoot != p) {
             return 0;
-        }
-
+        }
+
         return _sizes[p];
     }
 
-    void WeightedQuickUnion::connect(BtcId p, BtcId q) {
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::connect(Id p, Id q) {
         auto pRoot = findRoot(p);
         auto qRoot = findRoot(q);
 
         if (pRoot != qRoot) {
             // Balance insert
-            if (_sizes[pRoot] < _sizes[qRoot]) {
+            if (Size(_sizes[pRoot]) < Size(_sizes[qRoot])) {
                 // Insert p to q
-                _ids[pRoot] = qRoot;
-                _sizes[qRoot] += _sizes[pRoot];
+                link(pRoot, qRoot);
             }
             else {
                 // Insert q to p
-                _ids[qRoot] = pRoot;
-                _sizes[pRoot] += _sizes[qRoot];
+                link(qRoot, pRoot);
             }
-
-            -- _clusterCount;
         }
     }
 
-    void WeightedQuickUnion::merge(const WeightedQuickUnion& rhs) {
-        BtcId maxId = rhs._ids.size();
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::link(Id childRoot, Id parentRoot) {
+        _ids[childRoot] = parentRoot;
+        _sizes[parentRoot] = Size(_sizes[parentRoot]) + Size(_sizes[childRoot]);
+
+        -- _clusterCount;
+    }
+
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::merge(const BasicWeightedQuickUnion& rhs) {
+        Id maxId = rhs._ids.size();
 
-        for (BtcId p = 0; p != maxId; ++p) {
-            auto q = rhs._ids[p];
+        for (Id p = 0; p != maxId; ++p) {
+            Id q = rhs._ids[p];
             if (p != q) {
                 connect(p, q);
             }
         }
     }
 
-    void WeightedQuickUnion::save(const fs::path& path) const {
+    // Applied days manifest of legacy files is appended after sizes behind this magic
+    static const char APPLIED_DAYS_MAGIC[8] = { 'U', 'F', 'D', 'A', 'Y', 'S', '0', '1' };
+
+    // Read as a legacy header the magic would give clusterCount > maxId, which no legacy file has
+    static const char UNION_FIND_FILE_MAGIC[8] = { 'B', 'T', 'C', 'U', 'F', '0', '0', '2' };
+    static const uint32_t UNION_FIND_FILE_VERSION = 2;
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // Sections which aren't kept in memory are read in chunks of this many ids
+    static const std::size_t SECTION_CHUNK_COUNT = 1024 * 1024;
+
+    // FNV-1a style hash over 8 byte words, a partial word is carried over to the next update
+    class UnionFindChecksum {
+    public:
+        void update(const void* data, std::size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+
+            while (size) {
+                if (_pendingSize || size < sizeof(uint64_t)) {
+                    std::size_t copySize = std::min(size, sizeof(uint64_t) - _pendingSize);
+                    std::memcpy(_pending + _pendingSize, bytes, copySize);
+                    _pendingSize += copySize;
+                    bytes += copySize;
+                    size -= copySize;
+
+                    if (_pendingSize == sizeof(uint64_t)) {
+                        mix(_pending);
+                        _pendingSize = 0;
+                    }
+
+                    continue;
+                }
+
+                mix(bytes);
+                bytes += sizeof(uint64_t);
+                size -= sizeof(uint64_t);
+            }
+        }
+
+        uint64_t digest() const {
+            uint64_t hash = _hash;
+            for (std::size_t pendingIndex = 0; pendingIndex != _pendingSize; ++pendingIndex) {
+                hash = (hash ^ uint8_t(_pending[pendingIndex])) * PRIME;
+            }
+
+            return hash;
+        }
+
+    private:
+        void mix(const char* word) {
+            uint64_t value = 0;
+            std::memcpy(&value, word, sizeof(value));
+            _hash = std::rotl((_hash ^ value) * PRIME, 31);
+        }
+
+        static const uint64_t PRIME = 0x100000001b3;
+
+        uint64_t _hash = 0xcbf29ce484222325;
+        char _pending[sizeof(uint64_t)] = { 0 };
+        std::size_t _pendingSize = 0;
+    };
+
+    struct UnionFindFileLayout {
+        bool isLegacy;
+        uint64_t clusterCount;
+        uint64_t idCount;
+        uint64_t idsOffset;
+        uint64_t sizesOffset;
+        uint64_t rootsOffset;
+        uint64_t appliedDaysOffset;
+        uint64_t checksum;
+    };
+
+    template <typename IdStorage>
+    static UnionFindFileLayout parseUnionFindFileHeader(
+        const char* data,
+        std::size_t dataSize,
+        uint64_t fileSize,
+        const fs::path& path
+    ) {
+        using Id = typename IdTraits<IdStorage>::Id;
+
+        UnionFindFileLayout layout = {};
+        if (dataSize >= sizeof(UnionFindFileHeader) &&
+            std::equal(UNION_FIND_FILE_MAGIC, UNION_FIND_FILE_MAGIC + sizeof(UNION_FIND_FILE_MAGIC), data)) {
+            UnionFindFileHeader header;
+            std::memcpy(&header, data, sizeof(header));
+
+            if (header.byteOrderMark != BYTE_ORDER_MARK) {
+                throw std::runtime_error(fmt::format("Union find file {} is written in another byte order", path.string()));
+            }
+
+            if (header.version > UNION_FIND_FILE_VERSION) {
+                throw std::runtime_error(fmt::format(
+                    "Union find file {} has unsupported version {}", path.string(), header.version
+                ));
+            }
+
+            if (header.idBytes != sizeof(IdStorage)) {
+                throw std::runtime_error(fmt::format(
+                    "Union find file {} has {} bytes ids, expected {}", path.string(), header.idBytes, sizeof(IdStorage)
+                ));
+            }
+
+            layout.isLegacy = false;
+            layout.clusterCount = header.clusterCount;
+            layout.idCount = header.idCount;
+            layout.idsOffset = header.idsOffset;
+            layout.sizesOffset = header.sizesOffset;
+            layout.rootsOffset = header.rootsOffset;
+            layout.appliedDaysOffset = header.appliedDaysOffset;
+            layout.checksum = header.checksum;
+        }
+        else {
+            if (dataSize < 2 * sizeof(Id)) {
+                throw std::runtime_error(fmt::format("Invalid union find file {}", path.string()));
+            }
+
+            Id clusterCount = 0;
+            Id idCount = 0;
+            std::memcpy(&clusterCount, data, sizeof(Id));
+            std::memcpy(&idCount, data + sizeof(Id), sizeof(Id));
+
+            layout.isLegacy = true;
+            layout.clusterCount = clusterCount;
+            layout.idCount = idCount;
+            layout.idsOffset = 2 * sizeof(Id);
+            layout.sizesOffset = layout.idsOffset + idCount * sizeof(IdStorage);
+            layout.appliedDaysOffset = layout.sizesOffset + idCount * sizeof(IdStorage);
+        }
+
+        uint64_t sectionBytes = layout.idCount * sizeof(IdStorage);
+        if (layout.idsOffset + sectionBytes > fileSize ||
+            layout.sizesOffset + sectionBytes > fileSize ||
+            (layout.rootsOffset && layout.rootsOffset + sectionBytes > fileSize)) {
+            throw std::runtime_error(fmt::format("Union find file {} is truncated", path.string()));
+        }
+
+        return layout;
+    }
+
+    template <typename IdStorage>
+    static UnionFindFileLayout readUnionFindFileLayout(std::ifstream& inputFile, const fs::path& path) {
+        if (!inputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open union find file {}", path.string()));
+        }
+
+        uint64_t fileSize = fs::file_size(path);
+        char headerData[sizeof(UnionFindFileHeader)] = { 0 };
+        std::size_t headerDataSize = std::min<uint64_t>(fileSize, sizeof(headerData));
+        inputFile.read(headerData, headerDataSize);
+
+        return parseUnionFindFileHeader<IdStorage>(headerData, headerDataSize, fileSize, path);
+    }
+
+    // Streams a section of count ids through a fixed size buffer
+    template <typename IdStorage, typename ChunkFunc>
+    static void readIdSectionInChunks(std::ifstream& inputFile, uint64_t offset, uint64_t count, ChunkFunc handler) {
+        std::vector<IdStorage> chunk(std::min<uint64_t>(count, SECTION_CHUNK_COUNT));
+
+        inputFile.seekg(offset);
+        for (uint64_t chunkBegin = 0; chunkBegin < count; chunkBegin += chunk.size()) {
+            std::size_t chunkCount = std::min<uint64_t>(count - chunkBegin, chunk.size());
+            inputFile.read(reinterpret_cast<char*>(chunk.data()), chunkCount * sizeof(IdStorage));
+
+            handler(chunkBegin, chunk.data(), chunkCount);
+        }
+    }
+
+    static std::string serializeAppliedDays(const std::vector<std::string>& appliedDays) {
+        std::string buffer;
+
+        uint32_t dayCount = appliedDays.size();
+        buffer.append(reinterpret_cast<const char*>(&dayCount), sizeof(dayCount));
+        for (const auto& day : appliedDays) {
+            uint32_t dayLength = day.size();
+            buffer.append(reinterpret_cast<const char*>(&dayLength), sizeof(dayLength));
+            buffer.append(day);
+        }
+
+        return buffer;
+    }
+
+    static void parseAppliedDays(const std::string& buffer, std::vector<std::string>& appliedDays) {
+        uint32_t dayCount = 0;
+        if (buffer.size() < sizeof(dayCount)) {
+            return;
+        }
+
+        std::memcpy(&dayCount, buffer.data(), sizeof(dayCount));
+        std::size_t offset = sizeof(dayCount);
+
+        appliedDays.reserve(dayCount);
+        for (uint32_t dayIndex = 0; dayIndex != dayCount && offset + sizeof(uint32_t) <= buffer.size(); ++dayIndex) {
+            uint32_t dayLength = 0;
+            std::memcpy(&dayLength, buffer.data() + offset, sizeof(dayLength));
+            offset += sizeof(dayLength);
+
+            if (offset + dayLength > buffer.size()) {
+                break;
+            }
+
+            appliedDays.push_back(buffer.substr(offset, dayLength));
+            offset += dayLength;
+        }
+    }
+
+    // Reads the sections after sizes and verifies the checksum, which already covers ids and sizes
+    template <typename IdStorage>
+    static void readUnionFindFileTail(
+        std::ifstream& inputFile,
+        const UnionFindFileLayout& layout,
+        UnionFindChecksum& checksum,
+        std::vector<std::string>& appliedDays,
+        const fs::path& path
+    ) {
+        appliedDays.clear();
+
+        if (layout.isLegacy) {
+            inputFile.seekg(layout.appliedDaysOffset);
+
+            char magic[sizeof(APPLIED_DAYS_MAGIC)] = { 0 };
+            if (!inputFile.read(magic, sizeof(magic)) ||
+                !std::equal(magic, magic + sizeof(magic), APPLIED_DAYS_MAGIC)) {
+                return;
+            }
+
+            std::string appliedDaysBuffer{ std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>() };
+            parseAppliedDays(appliedDaysBuffer, appliedDays);
+
+            return;
+        }
+
+        // Frozen roots are for views only, they are read just to verify the checksum
+        if (layout.rootsOffset) {
+            readIdSectionInChunks<IdStorage>(
+                inputFile, layout.rootsOffset, layout.idCount,
+                [&](uint64_t, const IdStorage* roots, std::size_t count) {
+                    checksum.update(roots, count * sizeof(IdStorage));
+                }
+            );
+        }
+
+        if (layout.appliedDaysOffset) {
+            inputFile.seekg(layout.appliedDaysOffset);
+
+            std::string appliedDaysBuffer{ std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>() };
+            checksum.update(appliedDaysBuffer.data(), appliedDaysBuffer.size());
+            parseAppliedDays(appliedDaysBuffer, appliedDays);
+        }
+
+        if (checksum.digest() != layout.checksum) {
+            throw std::runtime_error(fmt::format("Checksum mismatch of union find file {}", path.string()));
+        }
+    }
+
+    // Sections follow the header in the order ids, sizes, roots, applied days
+    template <typename IdStorage>
+    static UnionFindFileHeader createUnionFindFileHeader(
+        uint64_t clusterCount,
+        uint64_t idCount,
+        bool hasRoots,
+        bool hasAppliedDays
+    ) {
+        uint64_t sectionBytes = idCount * sizeof(IdStorage);
+
+        UnionFindFileHeader header = {};
+        std::copy(UNION_FIND_FILE_MAGIC, UNION_FIND_FILE_MAGIC + sizeof(UNION_FIND_FILE_MAGIC), header.magic);
+        header.version = UNION_FIND_FILE_VERSION;
+        header.headerSize = sizeof(header);
+        header.byteOrderMark = BYTE_ORDER_MARK;
+        header.idBytes = sizeof(IdStorage);
+        header.clusterCount = clusterCount;
+        header.idCount = idCount;
+        header.idsOffset = sizeof(header);
+        header.sizesOffset = header.idsOffset + sectionBytes;
+
+        uint64_t nextOffset = header.sizesOffset + sectionBytes;
+        if (hasRoots) {
+            header.rootsOffset = nextOffset;
+            nextOffset += sectionBytes;
+        }
+        if (hasAppliedDays) {
+            header.appliedDaysOffset = nextOffset;
+        }
+
+        return header;
+    }
+
+    template <typename IdStorage>
+    static void writeUnionFindFile(
+        const fs::path& path,
+        uint64_t clusterCount,
+        const std::vector<IdStorage>& ids,
+        const std::vector<IdStorage>& sizes,
+        const std::vector<IdStorage>& roots,
+        const std::vector<std::string>& appliedDays
+    ) {
         std::ofstream outputFile(path.c_str(), std::ios::binary);
+        if (!outputFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open union find file {}", path.string()));
+        }
+
+        uint64_t sectionBytes = ids.size() * sizeof(IdStorage);
+        std::string appliedDaysBuffer = appliedDays.empty() ? "" : serializeAppliedDays(appliedDays);
+
+        auto header = createUnionFindFileHeader<IdStorage>(
+            clusterCount, ids.size(), !roots.empty(), !appliedDaysBuffer.empty()
+        );
+
+        UnionFindChecksum checksum;
+        checksum.update(ids.data(), sectionBytes);
+        checksum.update(sizes.data(), sectionBytes);
+        checksum.update(roots.data(), roots.size() * sizeof(IdStorage));
+        checksum.update(appliedDaysBuffer.data(), appliedDaysBuffer.size());
+        header.checksum = checksum.digest();
+
+        outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outputFile.write(reinterpret_cast<const char*>(ids.data()), sectionBytes);
+        outputFile.write(reinterpret_cast<const char*>(sizes.data()), sectionBytes);
+        outputFile.write(reinterpret_cast<const char*>(roots.data()), roots.size() * sizeof(IdStorage));
+        outputFile.write(appliedDaysBuffer.data(), appliedDaysBuffer.size());
+    }
+
+    // In memory ids of ConcurrentQuickUnion are full width for CAS, they are converted only when
+    // IdStorage is packed. Templated so the branch not taken isn't compiled.
+    template <typename IdStorage>
+    static void writeFullWidthUnionFindFile(
+        const fs::path& path,
+        uint64_t clusterCount,
+        const std::vector<BtcId>& ids,
+        const std::vector<BtcId>& sizes
+    ) {
+        if constexpr (std::is_same_v<IdStorage, BtcId>) {
+            writeUnionFindFile<IdStorage>(path, clusterCount, ids, sizes, {}, {});
+        }
+        else {
+            writeUnionFindFile<IdStorage>(
+                path,
+                clusterCount,
+                std::vector<IdStorage>(ids.begin(), ids.end()),
+                std::vector<IdStorage>(sizes.begin(), sizes.end()),
+                {},
+                {}
+            );
+        }
+    }
+
+    template <typename IdStorage, typename QuickUnion>
+    static std::vector<IdStorage> freezeRoots(const QuickUnion& quickUnion) {
+        using Id = typename QuickUnion::Id;
 
-        outputFile.write(reinterpret_cast<const char*>(&_clusterCount), sizeof(_clusterCount));
+        std::vector<IdStorage> roots(quickUnion.getSize());
 
-        BtcId maxId = _ids.size();
-        outputFile.write(reinterpret_cast<const char*>(&maxId), sizeof(BtcId));
-        outputFile.write(reinterpret_cast<const char*>(_ids.data()), _ids.size() * sizeof(BtcId));
-        outputFile.write(reinterpret_cast<const char*>(_sizes.data()), _sizes.size() * sizeof(BtcSize));
+        Id maxId = quickUnion.getSize();
+        for (Id p = 0; p != maxId; ++p) {
+            roots[p] = quickUnion.findRoot(p);
+        }
+
+        return roots;
     }
 
-    void WeightedQuickUnion::load(const fs::path& path) {
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::save(const fs::path& path) const {
+        save(path, std::vector<std::string>());
+    }
+
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::save(
+        const fs::path& path,
+        const std::vector<std::string>& appliedDays,
+        bool withFrozenRoots
+    ) const {
+        writeUnionFindFile(
+            path,
+            _clusterCount,
+            _ids,
+            _sizes,
+            withFrozenRoots ? freezeRoots<IdStorage>(*this) : std::vector<IdStorage>(),
+            appliedDays
+        );
+    }
+
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::load(const fs::path& path) {
+        std::vector<std::string> appliedDays;
+        load(path, appliedDays);
+    }
+
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::load(const fs::path& path, std::vector<std::string>& appliedDays) {
         std::ifstream inputFile(path.c_str(), std::ios::binary);
+        const auto& layout = readUnionFindFileLayout<IdStorage>(inputFile, path);
+
+        _clusterCount = layout.clusterCount;
 
-        inputFile.read(reinterpret_cast<char*>(&_clusterCount), sizeof(_clusterCount));
+        _ids.resize(layout.idCount);
+        inputFile.seekg(layout.idsOffset);
+        inputFile.read(reinterpret_cast<char*>(_ids.data()), _ids.size() * sizeof(IdStorage));
+        _sizes.resize(layout.idCount);
+        inputFile.seekg(layout.sizesOffset);
+        inputFile.read(reinterpret_cast<char*>(_sizes.data()), _sizes.size() * sizeof(IdStorage));
 
-        BtcId maxId = 0;
-        inputFile.read(reinterpret_cast<char*>(&maxId), sizeof(BtcId));
+        UnionFindChecksum checksum;
+        if (!layout.isLegacy) {
+            checksum.update(_ids.data(), _ids.size() * sizeof(IdStorage));
+            checksum.update(_sizes.data(), _sizes.size() * sizeof(IdStorage));
+        }
 
-        _ids.resize(maxId);
-        inputFile.read(reinterpret_cast<char*>(_ids.data()), _ids.size() * sizeof(BtcId));
-        _sizes.resize(maxId);
-        inputFile.read(reinterpret_cast<char*>(_sizes.data()), _sizes.size() * sizeof(BtcSize));
+        readUnionFindFileTail<IdStorage>(inputFile, layout, checksum, appliedDays, path);
     }
 
-    void WeightedQuickUnion::resize(BtcSize newSize) {
+    template <typename IdStorage>
+    void BasicWeightedQuickUnion<IdStorage>::resize(Size newSize) {
         auto originalSize = getSize();
         if (originalSize >= newSize) {
             return;
@@ -105,13 +578,14 @@ namespace utils::btc {
 
         _clusterCount += newSize - originalSize;
 
-        for (BtcId currentId = originalSize; originalSize < newSize; ++originalSize) {
+        for (Id currentId = originalSize; currentId < newSize; ++currentId) {
             _ids[currentId] = currentId;
             _sizes[currentId] = 1;
         }
     }
 
-    std::ostream& operator<<(std::ostream& os, const WeightedQuickUnion& quickUnion) {
+    template <typename IdStorage>
+    std::ostream& operator<<(std::ostream& os, const BasicWeightedQuickUnion<IdStorage>& quickUnion) {
         os << fmt::format("Cluster count: {}", quickUnion._clusterCount) << std::endl;
 
         os << "Ids size:" << quickUnion._ids.size() << std::endl;
@@ -123,14 +597,17 @@ namespace utils::btc {
         return os;
     }
 
-    WeightedQuickUnionClusters::WeightedQuickUnionClusters(const WeightedQuickUnion& quickUnion) :
-        _quickUnion(quickUnion) {}
+    template <typename IdStorage>
+    BasicWeightedQuickUnionClusters<IdStorage>::BasicWeightedQuickUnionClusters(
+        const BasicWeightedQuickUnion<IdStorage>& quickUnion
+    ) : _quickUnion(quickUnion) {}
 
-    void WeightedQuickUnionClusters::forEach(ForEachFunc handler) const {
-        BtcSize currentId = 0;
+    template <typename IdStorage>
+    void BasicWeightedQuickUnionClusters<IdStorage>::forEach(ForEachFunc handler) const {
+        Id currentId = 0;
 
-        for (auto currentParent : _quickUnion._ids) {
-            auto currentSize = _quickUnion._sizes[currentId];
+        for (Id currentParent : _quickUnion._ids) {
+            Size currentSize = _quickUnion._sizes[currentId];
 
             if (currentParent == currentId) {
                 handler(currentId, currentSize);
@@ -140,4 +617,722 @@ namespace utils::btc {
         }
     }
 
+    template class BasicWeightedQuickUnion<uint32_t>;
+    template class BasicWeightedQuickUnion<uint64_t>;
+    template class BasicWeightedQuickUnion<PackedId40>;
+
+    template std::ostream& operator<<(std::ostream& os, const BasicWeightedQuickUnion<uint32_t>& quickUnion);
+    template std::ostream& operator<<(std::ostream& os, const BasicWeightedQuickUnion<uint64_t>& quickUnion);
+    template std::ostream& operator<<(std::ostream& os, const BasicWeightedQuickUnion<PackedId40>& quickUnion);
+
+    template class BasicWeightedQuickUnionClusters<uint32_t>;
+    template class BasicWeightedQuickUnionClusters<uint64_t>;
+    template class BasicWeightedQuickUnionClusters<PackedId40>;
+
+    template <typename IdStorage>
+    BasicRankedQuickUnion<IdStorage>::BasicRankedQuickUnion(Size idCount) :
+        _ids(idCount, 0), _ranks(idCount, 0), _clusterCount(idCount) {
+        Size currentId = 0;
+        for (auto& id : _ids) {
+            id = currentId;
+
+            ++currentId;
+        }
+    }
+
+    template <typename IdStorage>
+    bool BasicRankedQuickUnion<IdStorage>::connected(Id p, Id q) {
+        return findRootAndHalve(p) == findRootAndHalve(q);
+    }
+
+    template <typename IdStorage>
+    typename BasicRankedQuickUnion<IdStorage>::Id BasicRankedQuickUnion<IdStorage>::findRoot(Id p) const {
+        while (p != _ids[p]) {
+            p = _ids[p];
+        }
+
+        return p;
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::findRoots(std::span<const Id> in, std::span<Id> out) const {
+        findRootsInterleaved(_ids.data(), in, out);
+    }
+
+    template <typename IdStorage>
+    typename BasicRankedQuickUnion<IdStorage>::Id BasicRankedQuickUnion<IdStorage>::findRootAndHalve(Id p) {
+        while (p != _ids[p]) {
+            // Point every other node on the path to its grandparent
+            _ids[p] = Id(_ids[_ids[p]]);
+            p = _ids[p];
+        }
+
+        return p;
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::connect(Id p, Id q) {
+        auto pRoot = findRootAndHalve(p);
+        auto qRoot = findRootAndHalve(q);
+
+        if (pRoot == qRoot) {
+            return;
+        }
+
+        if (_ranks[pRoot] < _ranks[qRoot]) {
+            _ids[pRoot] = qRoot;
+        }
+        else if (_ranks[pRoot] > _ranks[qRoot]) {
+            _ids[qRoot] = pRoot;
+        }
+        else {
+            _ids[qRoot] = pRoot;
+            ++_ranks[pRoot];
+        }
+
+        -- _clusterCount;
+        dropRootSizes();
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::dropRootSizes() {
+        if (_rootSizes) {
+            _rootSizes.reset();
+        }
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::merge(const BasicRankedQuickUnion& rhs) {
+        Id maxId = rhs._ids.size();
+
+        for (Id p = 0; p != maxId; ++p) {
+            Id q = rhs._ids[p];
+            if (p != q) {
+                connect(p, q);
+            }
+        }
+    }
+
+    template <typename IdStorage>
+    std::vector<IdStorage> BasicRankedQuickUnion<IdStorage>::computeClusterSizes() const {
+        std::vector<IdStorage> sizes(_ids.size(), 0);
+
+        Id maxId = _ids.size();
+        for (Id p = 0; p != maxId; ++p) {
+            Id pRoot = findRoot(p);
+            sizes[pRoot] = Size(sizes[pRoot]) + 1;
+        }
+
+        return sizes;
+    }
+
+    template <typename IdStorage>
+    const std::vector<std::pair<IdStorage, IdStorage>>& BasicRankedQuickUnion<IdStorage>::getRootSizes() const {
+        std::lock_guard<std::mutex> rootSizesLock(_rootSizesMutex);
+        if (_rootSizes) {
+            return *_rootSizes;
+        }
+
+        // Most roots are singletons, so only the others are counted and no id sized array is needed
+        auto rootSizes = std::make_unique<std::vector<std::pair<IdStorage, IdStorage>>>();
+        Id maxId = _ids.size();
+        for (Id p = 0; p != maxId; ++p) {
+            if (Id(_ids[p]) == p && _ranks[p]) {
+                rootSizes->emplace_back(p, 0);
+            }
+        }
+
+        auto compareRoot = [](const std::pair<IdStorage, IdStorage>& rootSize, Id root) {
+            return Id(rootSize.first) < root;
+        };
+        for (Id p = 0; p != maxId; ++p) {
+            Id pRoot = findRoot(p);
+            if (pRoot == p && !_ranks[p]) {
+                continue;
+            }
+
+            auto rootSizeIt = std::lower_bound(rootSizes->begin(), rootSizes->end(), pRoot, compareRoot);
+            rootSizeIt->second = Size(rootSizeIt->second) + 1;
+        }
+
+        _rootSizes = std::move(rootSizes);
+
+        return *_rootSizes;
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::save(const fs::path& path) const {
+        save(path, std::vector<std::string>());
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::save(
+        const fs::path& path,
+        const std::vector<std::string>& appliedDays,
+        bool withFrozenRoots
+    ) const {
+        // Same layout as WeightedQuickUnion, only sizes of roots are meaningful
+        writeUnionFindFile(
+            path,
+            _clusterCount,
+            _ids,
+            computeClusterSizes(),
+            withFrozenRoots ? freezeRoots<IdStorage>(*this) : std::vector<IdStorage>(),
+            appliedDays
+        );
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::load(const fs::path& path) {
+        std::vector<std::string> appliedDays;
+        load(path, appliedDays);
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::load(const fs::path& path, std::vector<std::string>& appliedDays) {
+        std::ifstream inputFile(path.c_str(), std::ios::binary);
+        const auto& layout = readUnionFindFileLayout<IdStorage>(inputFile, path);
+        dropRootSizes();
+
+        _clusterCount = layout.clusterCount;
+
+        _ids.resize(layout.idCount);
+        inputFile.seekg(layout.idsOffset);
+        inputFile.read(reinterpret_cast<char*>(_ids.data()), _ids.size() * sizeof(IdStorage));
+
+        UnionFindChecksum checksum;
+        if (!layout.isLegacy) {
+            checksum.update(_ids.data(), _ids.size() * sizeof(IdStorage));
+        }
+
+        // A tree of size n has rank at most log2(n), so the bound keeps the union by rank guarantee
+        _ranks.assign(layout.idCount, 0);
+        readIdSectionInChunks<IdStorage>(
+            inputFile, layout.sizesOffset, layout.idCount,
+            [&](uint64_t chunkBegin, const IdStorage* sizes, std::size_t count) {
+                if (!layout.isLegacy) {
+                    checksum.update(sizes, count * sizeof(IdStorage));
+                }
+
+                for (std::size_t chunkIndex = 0; chunkIndex != count; ++chunkIndex) {
+                    Id p = chunkBegin + chunkIndex;
+                    Size size = sizes[chunkIndex];
+                    if (Id(_ids[p]) == p && size > 1) {
+                        _ranks[p] = std::bit_width(uint64_t(size)) - 1;
+                    }
+                }
+            }
+        );
+
+        readUnionFindFileTail<IdStorage>(inputFile, layout, checksum, appliedDays, path);
+    }
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnion<IdStorage>::resize(Size newSize) {
+        auto originalSize = getSize();
+        if (originalSize >= newSize) {
+            return;
+        }
+
+        _ids.resize(newSize);
+        _ranks.resize(newSize, 0);
+        dropRootSizes();
+
+        _clusterCount += newSize - originalSize;
+
+        for (Id currentId = originalSize; currentId < newSize; ++currentId) {
+            _ids[currentId] = currentId;
+        }
+    }
+
+    template <typename IdStorage>
+    BasicRankedQuickUnionClusters<IdStorage>::BasicRankedQuickUnionClusters(
+        const BasicRankedQuickUnion<IdStorage>& quickUnion
+    ) : _quickUnion(quickUnion) {}
+
+    template <typename IdStorage>
+    void BasicRankedQuickUnionClusters<IdStorage>::forEach(ForEachFunc handler) const {
+        // Roots come in id order like the root sizes, so one cursor walks both
+        const auto& rootSizes = _quickUnion.getRootSizes();
+        auto rootSizeIt = rootSizes.cbegin();
+        Id currentId = 0;
+
+        for (Id currentParent : _quickUnion._ids) {
+            if (currentParent == currentId) {
+                if (_quickUnion._ranks[currentId]) {
+                    handler(currentId, Size(rootSizeIt->second));
+                    ++rootSizeIt;
+                }
+                else {
+                    handler(currentId, 1);
+                }
+            }
+
+            ++currentId;
+        }
+    }
+
+    template class BasicRankedQuickUnion<uint32_t>;
+    template class BasicRankedQuickUnion<uint64_t>;
+    template class BasicRankedQuickUnion<PackedId40>;
+
+    template class BasicRankedQuickUnionClusters<uint32_t>;
+    template class BasicRankedQuickUnionClusters<uint64_t>;
+    template class BasicRankedQuickUnionClusters<PackedId40>;
+
+    template <typename IdStorage>
+    BasicUnionFindView<IdStorage>::BasicUnionFindView(const fs::path& path) :
+        _path(path), _file(path.string()), _ids(nullptr), _sizes(nullptr), _roots(nullptr), _clusterCount(0), _idCount(0),
+        _checksum(0) {
+        const auto& layout = parseUnionFindFileHeader<IdStorage>(_file.data(), _file.size(), _file.size(), path);
+
+        _clusterCount = layout.clusterCount;
+        _idCount = layout.idCount;
+        _checksum = layout.checksum;
+        _ids = reinterpret_cast<const IdStorage*>(_file.data() + layout.idsOffset);
+        _sizes = reinterpret_cast<const IdStorage*>(_file.data() + layout.sizesOffset);
+        if (layout.rootsOffset) {
+            _roots = reinterpret_cast<const IdStorage*>(_file.data() + layout.rootsOffset);
+        }
+    }
+
+    template <typename IdStorage>
+    typename BasicUnionFindView<IdStorage>::Id BasicUnionFindView<IdStorage>::findRoot(Id p) const {
+        if (_roots) {
+            return _roots[p];
+        }
+
+        while (p != _ids[p]) {
+            p = _ids[p];
+        }
+
+        return p;
+    }
+
+    template <typename IdStorage>
+    void BasicUnionFindView<IdStorage>::findRoots(std::span<const Id> in, std::span<Id> out) const {
+        if (!_roots) {
+            findRootsInterleaved(_ids, in, out);
+
+            return;
+        }
+
+        // One read per lookup, prefetch a group ahead
+        std::size_t inputCount = in.size();
+        for (std::size_t inputIndex = 0; inputIndex != inputCount; ++inputIndex) {
+            if (inputIndex + FIND_ROOTS_GROUP_SIZE < inputCount) {
+                prefetchRead(_roots + in[inputIndex + FIND_ROOTS_GROUP_SIZE]);
+            }
+
+            out[inputIndex] = _roots[in[inputIndex]];
+        }
+    }
+
+    template <typename IdStorage>
+    typename BasicUnionFindView<IdStorage>::Size BasicUnionFindView<IdStorage>::getClusterSize(Id p) const {
+        if (Id(_ids[p]) != p) {
+            return 0;
+        }
+
+        return _sizes[p];
+    }
+
+    template class BasicUnionFindView<uint32_t>;
+    template class BasicUnionFindView<uint64_t>;
+    template class BasicUnionFindView<PackedId40>;
+
+    ConcurrentQuickUnion::ConcurrentQuickUnion(BtcSize idCount) : _ids(idCount, 0) {
+        BtcId currentId = 0;
+        for (auto& id : _ids) {
+            id = currentId;
+
+            ++currentId;
+        }
+    }
+
+    BtcId ConcurrentQuickUnion::findRoot(BtcId p) {
+        while (true) {
+            BtcId parent = std::atomic_ref<BtcId>(_ids[p]).load(std::memory_order_acquire);
+            if (parent == p) {
+                return p;
+            }
+
+            BtcId grandParent = std::atomic_ref<BtcId>(_ids[parent]).load(std::memory_order_acquire);
+            if (grandParent != parent) {
+                // Path halving, losing the race only means less compression
+                std::atomic_ref<BtcId>(_ids[p]).compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+            }
+
+            p = grandParent;
+        }
+    }
+
+    void ConcurrentQuickUnion::connect(BtcId p, BtcId q) {
+        while (true) {
+            p = findRoot(p);
+            q = findRoot(q);
+            if (p == q) {
+                return;
+            }
+
+            if (p < q) {
+                std::swap(p, q);
+            }
+
+            // Fails if another thread linked p meanwhile, then retry from the new roots
+            BtcId expectedParent = p;
+            if (std::atomic_ref<BtcId>(_ids[p]).compare_exchange_strong(
+                expectedParent, q, std::memory_order_acq_rel
+            )) {
+                return;
+            }
+        }
+    }
+
+    void ConcurrentQuickUnion::merge(const fs::path& path, uint32_t workerCount) {
+        std::ifstream inputFile(path.c_str(), std::ios::binary);
+        const auto& layout = readUnionFindFileLayout<BtcIdStorage>(inputFile, path);
+
+        resize(layout.idCount);
+
+        // One pool of workers for the whole file, each takes the next chunk under the lock and connects it
+        // while the others read, instead of starting new threads for every chunk
+        std::mutex inputMutex;
+        uint64_t nextChunkBegin = 0;
+        inputFile.seekg(layout.idsOffset);
+        workerCount = std::max(workerCount, 1u);
+        utils::runRangesInParallel(workerCount, workerCount, [&](uint64_t, uint64_t) {
+            std::vector<BtcIdStorage> ids(std::min<uint64_t>(layout.idCount, SECTION_CHUNK_COUNT));
+            while (true) {
+                uint64_t chunkBegin = 0;
+                std::size_t chunkCount = 0;
+                {
+                    std::lock_guard<std::mutex> lock(inputMutex);
+                    if (nextChunkBegin >= layout.idCount) {
+                        return;
+                    }
+
+                    chunkBegin = nextChunkBegin;
+                    chunkCount = std::min<uint64_t>(layout.idCount - chunkBegin, ids.size());
+                    if (!inputFile.read(reinterpret_cast<char*>(ids.data()), chunkCount * sizeof(BtcIdStorage))) {
+                        throw std::runtime_error(fmt::format("Union find file {} is truncated", path.string()));
+                    }
+                    nextChunkBegin += chunkCount;
+                }
+
+                for (std::size_t chunkIndex = 0; chunkIndex != chunkCount; ++chunkIndex) {
+                    BtcId p = chunkBegin + chunkIndex;
+                    BtcId q = ids[chunkIndex];
+                    if (p != q) {
+                        connect(p, q);
+                    }
+                }
+            }
+        });
+    }
+
+    void ConcurrentQuickUnion::save(const fs::path& path, uint32_t workerCount) {
+        BtcSize idCount = _ids.size();
+
+        utils::runRangesInParallel(idCount, workerCount, [&](BtcId beginId, BtcId endId) {
+            for (BtcId p = beginId; p != endId; ++p) {
+                std::atomic_ref<BtcId>(_ids[p]).store(findRoot(p), std::memory_order_relaxed);
+            }
+        });
+
+        std::vector<BtcId> sizes(idCount, 0);
+        std::atomic<uint64_t> clusterCount = 0;
+        utils::runRangesInParallel(idCount, workerCount, [&](BtcId beginId, BtcId endId) {
+            uint64_t rangeClusterCount = 0;
+            for (BtcId p = beginId; p != endId; ++p) {
+                BtcId pRoot = _ids[p];
+                std::atomic_ref<BtcId>(sizes[pRoot]).fetch_add(1, std::memory_order_relaxed);
+
+                if (pRoot == p) {
+                    ++rangeClusterCount;
+                }
+            }
+
+            clusterCount += rangeClusterCount;
+        });
+
+        writeFullWidthUnionFindFile<BtcIdStorage>(path, clusterCount, _ids, sizes);
+    }
+
+    void ConcurrentQuickUnion::resize(BtcSize newSize) {
+        BtcSize originalSize = _ids.size();
+        if (originalSize >= newSize) {
+            return;
+        }
+
+        _ids.resize(newSize);
+        for (BtcId currentId = originalSize; currentId < newSize; ++currentId) {
+            _ids[currentId] = currentId;
+        }
+    }
+
+    ExternalQuickUnion::ExternalQuickUnion(const fs::path& path, BtcSize idCount, std::size_t edgeBufferCount) :
+        _path(path),
+        _file(path.string(), sizeof(UnionFindFileHeader) + 2 * uint64_t(idCount) * sizeof(BtcIdStorage)),
+        _ids(reinterpret_cast<BtcIdStorage*>(_file.data() + sizeof(UnionFindFileHeader))),
+        _sizes(_ids + idCount),
+        _edgeBufferCount(std::max<std::size_t>(edgeBufferCount, 1)),
+        _idCount(idCount),
+        _clusterCount(idCount) {
+        for (BtcId p = 0; p != _idCount; ++p) {
+            _ids[p] = p;
+            _sizes[p] = 1;
+        }
+
+        _edges.reserve(_edgeBufferCount);
+    }
+
+    BtcId ExternalQuickUnion::findRoot(BtcId p) {
+        while (p != _ids[p]) {
+            _ids[p] = BtcId(_ids[_ids[p]]);
+            p = _ids[p];
+        }
+
+        return p;
+    }
+
+    void ExternalQuickUnion::connect(BtcId p, BtcId q) {
+        if (p == q) {
+            return;
+        }
+
+        _edges.emplace_back(std::min(p, q), std::max(p, q));
+        if (_edges.size() == _edgeBufferCount) {
+            flush();
+        }
+    }
+
+    void ExternalQuickUnion::flush() {
+        // In address order the first lookups of neighbouring edges share pages
+        std::sort(_edges.begin(), _edges.end());
+
+        for (const auto& [p, q] : _edges) {
+            auto pRoot = findRoot(p);
+            auto qRoot = findRoot(q);
+            if (pRoot == qRoot) {
+                continue;
+            }
+
+            if (BtcSize(_sizes[pRoot]) < BtcSize(_sizes[qRoot])) {
+                std::swap(pRoot, qRoot);
+            }
+
+            _ids[qRoot] = pRoot;
+            _sizes[pRoot] = BtcSize(_sizes[pRoot]) + BtcSize(_sizes[qRoot]);
+            -- _clusterCount;
+        }
+
+        _edges.clear();
+    }
+
+    void ExternalQuickUnion::close(const std::vector<std::string>& appliedDays) {
+        flush();
+
+        std::string appliedDaysBuffer = appliedDays.empty() ? "" : serializeAppliedDays(appliedDays);
+        auto header = createUnionFindFileHeader<BtcIdStorage>(
+            _clusterCount, _idCount, false, !appliedDaysBuffer.empty()
+        );
+
+        UnionFindChecksum checksum;
+        checksum.update(_ids, _idCount * sizeof(BtcIdStorage));
+        checksum.update(_sizes, _idCount * sizeof(BtcIdStorage));
+        checksum.update(appliedDaysBuffer.data(), appliedDaysBuffer.size());
+        header.checksum = checksum.digest();
+
+        _file.close();
+        _ids = nullptr;
+        _sizes = nullptr;
+
+        std::fstream outputFile(_path.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outputFile.seekp(0, std::ios::end);
+        outputFile.write(appliedDaysBuffer.data(), appliedDaysBuffer.size());
+    }
+
+    static const char UNION_LOG_MAGIC[8] = { 'U', 'F', 'L', 'O', 'G', '0', '0', '1' };
+    static const std::size_t UNION_LOG_BUFFER_COUNT = 1024 * 1024;
+
+    VersionedQuickUnion::VersionedQuickUnion(
+        BtcSize idCount,
+        const fs::path& logPath,
+        const std::vector<std::string>& days
+    ) : _quickUnion(idCount), _logFile(logPath.c_str(), std::ios::binary), _dayIndex(0), _loggedUnionCount(0) {
+        if (!_logFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open union log file {}", logPath.string()));
+        }
+
+        _logFile.write(UNION_LOG_MAGIC, sizeof(UNION_LOG_MAGIC));
+        _logFile.write(reinterpret_cast<const char*>(&idCount), sizeof(idCount));
+
+        uint32_t dayCount = days.size();
+        _logFile.write(reinterpret_cast<const char*>(&dayCount), sizeof(dayCount));
+        for (const auto& day : days) {
+            uint32_t dayLength = day.size();
+            _logFile.write(reinterpret_cast<const char*>(&dayLength), sizeof(dayLength));
+            _logFile.write(day.data(), dayLength);
+        }
+
+        _logBuffer.reserve(UNION_LOG_BUFFER_COUNT);
+    }
+
+    void VersionedQuickUnion::beginDay(uint32_t dayIndex) {
+        if (dayIndex < _dayIndex) {
+            throw std::invalid_argument(fmt::format("Days must be applied in order: {} after {}", dayIndex, _dayIndex));
+        }
+
+        _dayIndex = dayIndex;
+    }
+
+    void VersionedQuickUnion::connect(BtcId p, BtcId q) {
+        auto pRoot = _quickUnion.findRoot(p);
+        auto qRoot = _quickUnion.findRoot(q);
+
+        if (pRoot == qRoot) {
+            return;
+        }
+
+        // Same balance rule as WeightedQuickUnion::connect, so replaying links rebuilds the same trees
+        if (_quickUnion._sizes[pRoot] < _quickUnion._sizes[qRoot]) {
+            std::swap(pRoot, qRoot);
+        }
+
+        _quickUnion.link(qRoot, pRoot);
+        _logBuffer.push_back(UnionLogEntry{ _dayIndex, qRoot, pRoot });
+        ++_loggedUnionCount;
+
+        if (_logBuffer.size() == UNION_LOG_BUFFER_COUNT) {
+            flush();
+        }
+    }
+
+    void VersionedQuickUnion::flush() {
+        _logFile.write(
+            reinterpret_cast<const char*>(_logBuffer.data()),
+            _logBuffer.size() * sizeof(UnionLogEntry)
+        );
+        _logFile.flush();
+        _logBuffer.clear();
+    }
+
+    UnionLog::UnionLog(const fs::path& logPath) : _logPath(logPath), _idCount(0), _entriesOffset(0) {
+        std::ifstream logFile(logPath.c_str(), std::ios::binary);
+        if (!logFile.is_open()) {
+            throw std::runtime_error(fmt::format("Can't open union log file {}", logPath.string()));
+        }
+
+        char magic[sizeof(UNION_LOG_MAGIC)] = { 0 };
+        logFile.read(magic, sizeof(magic));
+        if (!std::equal(magic, magic + sizeof(magic), UNION_LOG_MAGIC)) {
+            throw std::runtime_error(fmt::format("Invalid union log file {}", logPath.string()));
+        }
+
+        logFile.read(reinterpret_cast<char*>(&_idCount), sizeof(_idCount));
+
+        uint32_t dayCount = 0;
+        logFile.read(reinterpret_cast<char*>(&dayCount), sizeof(dayCount));
+        _days.reserve(dayCount);
+        for (uint32_t dayIndex = 0; dayIndex != dayCount; ++dayIndex) {
+            uint32_t dayLength = 0;
+            logFile.read(reinterpret_cast<char*>(&dayLength), sizeof(dayLength));
+
+            std::string day(dayLength, '\0');
+            logFile.read(day.data(), dayLength);
+            _days.push_back(day);
+        }
+
+        _entriesOffset = logFile.tellg();
+    }
+
+    uint32_t UnionLog::findDayIndex(const std::string& cutoffDay) const {
+        uint32_t foundDayIndex = NO_DAY;
+
+        uint32_t dayCount = _days.size();
+        for (uint32_t dayIndex = 0; dayIndex != dayCount; ++dayIndex) {
+            if (getDayName(_days[dayIndex]) > cutoffDay) {
+                break;
+            }
+
+            foundDayIndex = dayIndex;
+        }
+
+        return foundDayIndex;
+    }
+
+    WeightedQuickUnion UnionLog::materialize(uint32_t cutoffDayIndex) const {
+        WeightedQuickUnion quickUnion(1);
+        materialize({ cutoffDayIndex }, [&quickUnion](uint32_t, const WeightedQuickUnion& materialized) {
+            quickUnion = materialized;
+        });
+
+        return quickUnion;
+    }
+
+    std::vector<BtcId> UnionLog::materializeRoots(uint32_t cutoffDayIndex) const {
+        const auto& quickUnion = materialize(cutoffDayIndex);
+
+        std::vector<BtcId> roots(quickUnion.getSize());
+        BtcId maxId = roots.size();
+        for (BtcId currentId = 0; currentId != maxId; ++currentId) {
+            roots[currentId] = quickUnion.findRoot(currentId);
+        }
+
+        return roots;
+    }
+
+    void UnionLog::materialize(std::vector<uint32_t> cutoffDayIndexes, MaterializeFunc handler) const {
+        // NO_DAY is the largest value, so cutoffs before the first day must be handled first
+        std::sort(cutoffDayIndexes.begin(), cutoffDayIndexes.end(), [](uint32_t lhs, uint32_t rhs) {
+            return static_cast<uint32_t>(lhs + 1) < static_cast<uint32_t>(rhs + 1);
+        });
+
+        std::ifstream logFile(_logPath.c_str(), std::ios::binary);
+        logFile.seekg(_entriesOffset);
+
+        WeightedQuickUnion quickUnion(_idCount);
+        auto cutoffIt = cutoffDayIndexes.begin();
+        while (cutoffIt != cutoffDayIndexes.end() && *cutoffIt == NO_DAY) {
+            handler(*cutoffIt, quickUnion);
+            ++cutoffIt;
+        }
+
+        std::vector<UnionLogEntry> entries(UNION_LOG_BUFFER_COUNT);
+        while (cutoffIt != cutoffDayIndexes.end() && logFile) {
+            logFile.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(UnionLogEntry));
+            std::size_t entryCount = logFile.gcount() / sizeof(UnionLogEntry);
+
+            for (std::size_t entryIndex = 0; entryIndex != entryCount; ++entryIndex) {
+                const auto& entry = entries[entryIndex];
+
+                while (cutoffIt != cutoffDayIndexes.end() && entry.dayIndex > *cutoffIt) {
+                    handler(*cutoffIt, quickUnion);
+                    ++cutoffIt;
+                }
+
+                if (cutoffIt == cutoffDayIndexes.end()) {
+                    break;
+                }
+
+                quickUnion.link(entry.childRoot, entry.parentRoot);
+            }
+        }
+
+        for (; cutoffIt != cutoffDayIndexes.end(); ++cutoffIt) {
+            handler(*cutoffIt, quickUnion);
+        }
+    }
+
+    std::string getDayName(const std::string& dayDir) {
+        fs::path dayPath(dayDir);
+        if (!dayPath.has_filename()) {
+            dayPath = dayPath.parent_path();
+        }
+
+        return dayPath.filename().string();
+    }
+
 }
\ No newline at end of file